@@ -0,0 +1,386 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+/******************************************************************************
+ * ActorNetwork.cpp
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * This class holds all of the details of the actor network which may or may
+ * not be used by the working memory system.
+ *
+ *****************************************************************************/
+
+#include <ActorNetwork.h>
+#include <FeatureVector.h>
+#include <feature_kernels.h>
+#include <layer.h>
+#include <neural_unit.h>
+#include <bp_full_forward_projection.h>
+#include <simple_linear_activation_function.h>
+#include <random_number_generator.h>
+#include <cstddef>
+#include <cstdlib>
+#include <cmath>
+
+void ActorNetwork::init() {
+  state_size = 0;
+  chunk_size = 0;
+  slots = 0;
+  input_size = 0;
+  learning_rate = WMTK_AN_LEARNING_RATE;
+  input_layer = NULL;
+  bias_layer = NULL;
+  output_layer = NULL;
+  input_output_projection = NULL;
+  bias_output_projection = NULL;
+  slaf = NULL;
+  candidate_count = 0;
+  candidate_capacity = 0;
+  candidate_inputs = NULL;
+  scores = NULL;
+  probabilities = NULL;
+  taken = NULL;
+  choices = NULL;
+  choices_valid = false;
+  slot_deltas = NULL;
+  slot_delta_ptrs = NULL;
+}
+
+void ActorNetwork::dispose() {
+  if (input_layer != NULL) {
+    delete input_output_projection;
+    delete bias_output_projection;
+    delete input_layer;
+    delete bias_layer;
+    delete output_layer;
+    delete slaf;
+  }
+
+  if (candidate_inputs != NULL)
+    delete [] candidate_inputs;
+  if (scores != NULL)
+    delete [] scores;
+  if (probabilities != NULL)
+    delete [] probabilities;
+  if (taken != NULL)
+    delete [] taken;
+  if (choices != NULL)
+    delete [] choices;
+  if (slot_deltas != NULL)
+    delete [] slot_deltas;
+  if (slot_delta_ptrs != NULL)
+    delete [] slot_delta_ptrs;
+
+  init();
+}
+
+void ActorNetwork::buildNetwork(int state, int chunk, int number_of_slots) {
+  state_size = state;
+  chunk_size = chunk;
+  slots = number_of_slots;
+  input_size = chunk_size * (state_size + 1);
+
+  slaf = new SimpleLinearActivationFunction();
+  bias_layer = new Layer(1, slaf);
+  bias_layer->getUnit(0)->setAct(1.0);
+  input_layer = new Layer(input_size, slaf);
+  output_layer = new Layer(slots, slaf);
+
+  input_output_projection = new BpFullForwardProjection(input_layer,
+							output_layer, 0);
+  input_output_projection->setLearningRate(learning_rate);
+  bias_output_projection = new BpFullForwardProjection(bias_layer,
+						       output_layer, 0);
+  bias_output_projection->setLearningRate(learning_rate);
+
+  choices = new int[slots];
+  slot_deltas = new double[slots];
+  slot_delta_ptrs = new double*[slots];
+  for (int x = 0; x < slots; x++) {
+    choices[x] = 0;
+    slot_deltas[x] = 0.0;
+    slot_delta_ptrs[x] = &slot_deltas[x];
+  }
+}
+
+void ActorNetwork::copy(const ActorNetwork& src) {
+  learning_rate = src.learning_rate;
+  if (src.input_layer == NULL)
+    return;
+
+  buildNetwork(src.state_size, src.chunk_size, src.slots);
+  input_output_projection->copyWeights(src.input_output_projection);
+  bias_output_projection->copyWeights(src.bias_output_projection);
+}
+
+ActorNetwork::ActorNetwork() {
+  init();
+}
+
+ActorNetwork::ActorNetwork(int state, int chunk, int number_of_slots) {
+  init();
+
+  if (state < 0 || chunk < 1 || number_of_slots < 1)
+    return;
+
+  buildNetwork(state, chunk, number_of_slots);
+}
+
+ActorNetwork::ActorNetwork(const ActorNetwork& L) {
+  init();
+  copy(L);
+}
+
+ActorNetwork::~ActorNetwork() {
+  dispose();
+}
+
+ActorNetwork& ActorNetwork::operator=(const ActorNetwork& Rhs) {
+  if (this != &Rhs) {
+    dispose();
+    copy(Rhs);
+  }
+  return *this;
+}
+
+int ActorNetwork::getInputSize() const {
+  return input_size;
+}
+
+int ActorNetwork::getNumberOfSlots() const {
+  return slots;
+}
+
+bool ActorNetwork::initializeWeights(RandomNumberGenerator& rng) {
+  if (input_layer == NULL)
+    return false;
+
+  return input_output_projection->initializeWeights(&rng) &&
+    bias_output_projection->initializeWeights(&rng);
+}
+
+void ActorNetwork::reserveCandidates(int count) {
+  if (count <= candidate_capacity)
+    return;
+
+  if (candidate_inputs != NULL)
+    delete [] candidate_inputs;
+  if (scores != NULL)
+    delete [] scores;
+  if (probabilities != NULL)
+    delete [] probabilities;
+  if (taken != NULL)
+    delete [] taken;
+
+  candidate_capacity = count;
+  candidate_inputs = new double[candidate_capacity * input_size];
+  scores = new double[candidate_capacity * slots];
+  probabilities = new double[candidate_capacity * slots];
+  taken = new bool[candidate_capacity];
+}
+
+// The input vector is the chunk vector followed by the chunk vector
+// scaled by each state feature in turn.
+void ActorNetwork::encodeCandidate(const FeatureVector& state, const FeatureVector& chunk, double* inputs) {
+  const double* s = state.getValues();
+  const double* c = chunk.getValues();
+
+  copyValues(inputs, c, chunk_size);
+  for (int x = 0; x < state_size; x++) {
+    inputs += chunk_size;
+    if (s[x] == 0.0)
+      fillValues(inputs, chunk_size, 0.0);
+    else
+      for (int y = 0; y < chunk_size; y++)
+	inputs[y] = s[x] * c[y];
+  }
+}
+
+bool ActorNetwork::evaluateCandidates(const FeatureVector& state, const FeatureVector* const* candidates, int count, const FeatureVector& empty) {
+  if (input_layer == NULL || count < 0 || (count > 0 && candidates == NULL) ||
+      state.getSize() != state_size || empty.getSize() != chunk_size)
+    return false;
+
+  int x;
+
+  for (x = 0; x < count; x++)
+    if (candidates[x] == NULL || candidates[x]->getSize() != chunk_size)
+      return false;
+
+  reserveCandidates(count + 1);
+  candidate_count = count + 1;
+  choices_valid = false;
+
+  for (x = 0; x < candidate_count; x++) {
+    double* inputs = candidate_inputs + (x * input_size);
+    encodeCandidate(state, x < count ? *candidates[x] : empty, inputs);
+
+    input_layer->bindActs(inputs);
+    output_layer->clearNets();
+    input_output_projection->adjustNets();
+    bias_output_projection->adjustNets();
+    output_layer->computeActivations();
+    output_layer->getActs(scores + (x * slots));
+  }
+  input_layer->bindActs(NULL);
+
+  return true;
+}
+
+bool ActorNetwork::selectChunks(int* selection) {
+  if (selection == NULL || candidate_count == 0)
+    return false;
+
+  int x, y;
+  int empty = candidate_count - 1;
+  double maximum, sum, draw;
+
+  for (x = 0; x < candidate_count; x++)
+    taken[x] = false;
+
+  for (y = 0; y < slots; y++) {
+    double* p = probabilities + (y * candidate_count);
+
+    // Once a slot is left empty, so are the rest (the contents of working
+    // memory are kept in its first slots), without a draw.
+    if (y > 0 && selection[y - 1] == -1) {
+      for (x = 0; x < candidate_count; x++)
+	p[x] = 0.0;
+      choices[y] = -1;
+      selection[y] = -1;
+      continue;
+    }
+
+    // Softmax over the free candidates, shifted by the largest score.
+    maximum = scores[(empty * slots) + y];
+    for (x = 0; x < empty; x++)
+      if (!taken[x] && scores[(x * slots) + y] > maximum)
+	maximum = scores[(x * slots) + y];
+
+    sum = 0.0;
+    for (x = 0; x < candidate_count; x++) {
+      if (taken[x])
+	p[x] = 0.0;
+      else
+	p[x] = exp(scores[(x * slots) + y] - maximum);
+      sum += p[x];
+    }
+    for (x = 0; x < candidate_count; x++)
+      p[x] /= sum;
+
+    // The empty chunk is always free, so it takes any rounding error.
+    choices[y] = empty;
+    draw = 1.0 * rand() / (RAND_MAX + 1.0);
+    for (x = 0; x < empty; x++) {
+      draw -= p[x];
+      if (draw < 0.0) {
+	choices[y] = x;
+	break;
+      }
+    }
+
+    if (choices[y] == empty)
+      selection[y] = -1;
+    else {
+      taken[choices[y]] = true;
+      selection[y] = choices[y];
+    }
+  }
+
+  choices_valid = true;
+  return true;
+}
+
+double ActorNetwork::getSelectionProbability(int slot, int candidate) const {
+  if (!choices_valid || slot < 0 || slot >= slots || candidate < -1 ||
+      candidate >= candidate_count - 1)
+    return 0.0;
+
+  if (candidate == -1)
+    candidate = candidate_count - 1;
+
+  return probabilities[(slot * candidate_count) + candidate];
+}
+
+bool ActorNetwork::learn(double td_error) {
+  if (!choices_valid)
+    return false;
+
+  int x, y;
+
+  // The gradient of the log probability of a slot's choice with respect
+  // to the candidates' scores is one for the choice less each
+  // candidate's probability.
+  for (x = 0; x < candidate_count; x++) {
+    for (y = 0; y < slots; y++) {
+      slot_deltas[y] = -probabilities[(y * candidate_count) + x];
+      if (choices[y] == x)
+	slot_deltas[y] += 1.0;
+      slot_deltas[y] *= td_error;
+    }
+
+    input_layer->bindActs(candidate_inputs + (x * input_size));
+    output_layer->setDeltas(slot_delta_ptrs);
+    input_output_projection->computeWeightChanges();
+    bias_output_projection->computeWeightChanges();
+  }
+  input_layer->bindActs(NULL);
+
+  input_output_projection->updateWeights();
+  bias_output_projection->updateWeights();
+
+  choices_valid = false;
+  return true;
+}
+
+bool ActorNetwork::writeWeights(ofstream& file_stream) {
+  if (input_layer == NULL)
+    return false;
+
+  return input_output_projection->writeWeights(file_stream) &&
+    bias_output_projection->writeWeights(file_stream);
+}
+
+bool ActorNetwork::readWeights(ifstream& file_stream) {
+  if (input_layer == NULL)
+    return false;
+
+  return input_output_projection->readWeights(file_stream) &&
+    bias_output_projection->readWeights(file_stream);
+}
+
+double ActorNetwork::getLearningRate() const {
+  return learning_rate;
+}
+
+bool ActorNetwork::setLearningRate(double value) {
+  if (value < 0.0)
+    return false;
+
+  learning_rate = value;
+  if (input_layer != NULL) {
+    input_output_projection->setLearningRate(learning_rate);
+    bias_output_projection->setLearningRate(learning_rate);
+  }
+  return true;
+}
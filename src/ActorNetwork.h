@@ -19,6 +19,7 @@
 // along with this program; if not, write to the Free Software
 // Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
+
 /******************************************************************************
  * ActorNetwork.h
  *
@@ -28,6 +29,21 @@
  * not be used by the working memory system. It will slow learning to use this
  * system, but results in faster performance once the system is trained-up.
  *
+ * The actor scores each candidate chunk for each working memory slot with
+ * one linear output unit per slot. A candidate's input vector is the
+ * conjunction of (1, state features) with its chunk features, so the
+ * scores can depend on the state as well as on the chunk. The slots are
+ * filled in order, each by drawing from a softmax over the candidates
+ * that are still free (and the empty chunk, which is always free, and
+ * which ends the filling when it is drawn), so a
+ * decision costs one forward pass per candidate instead of one critic
+ * evaluation per assignment of candidates to slots.
+ *
+ * The actor is trained by actor-critic: after each decision the output
+ * deltas are the critic's TD error times the gradient of the log
+ * probability of the choices made, and the weight changes are accumulated
+ * over the candidates by the backpropagation projections.
+ *
  * Joshua Phillips - 5/25/04 2:09PM
  * 		Created stub class for developing WorkingMemory class.
  *
@@ -36,12 +52,114 @@
 #ifndef WMTK_ACTOR_NETWORK_H
 #define WMTK_ACTOR_NETWORK_H
 
+// The critic learns slowly (see WMTK_CN_LEARNING_RATE), so its TD errors
+// are small and the actor's learning rate is large to make up for it.
+#define WMTK_AN_LEARNING_RATE 10.0
+
+#include <fstream>
+
+using namespace std;
+
+class FeatureVector;
+class Layer;
+class BpFullForwardProjection;
+class SimpleLinearActivationFunction;
+class RandomNumberGenerator;
+
 class ActorNetwork {
 
  public:
 
+  // Constructor
+  ActorNetwork();
+
+  // Constructor
+  // Creates an actor for number_of_slots slots, choosing among chunk
+  // vectors of size chunk_size given state vectors of size state_size.
+  ActorNetwork(int state_size, int chunk_size, int number_of_slots);
+
+  // Copy-Constructor
+  ActorNetwork(const ActorNetwork&);
+
+  // Destructor
+  ~ActorNetwork();
+
+  // Assignment Operator
+  ActorNetwork& operator=(const ActorNetwork&);
+
+  // Returns the size of the input vector of a candidate.
+  int getInputSize() const;
+
+  // Returns the number of slots the actor fills.
+  int getNumberOfSlots() const;
+
+  // Initializes the weights with values drawn from the
+  // RandomNumberGenerator.
+  bool initializeWeights(RandomNumberGenerator& rng);
+
+  // Scores the count candidate chunk vectors, plus the empty chunk
+  // vector, for every slot under the given state vector. Returns false
+  // if any vector has the wrong size.
+  bool evaluateCandidates(const FeatureVector& state,
+			  const FeatureVector* const* candidates,
+			  int count,
+			  const FeatureVector& empty);
+
+  // Fills the slots from the candidates last evaluated: selection[x] is
+  // set to the index of the candidate drawn for slot x, or -1 for the
+  // empty chunk. No candidate is drawn for more than one slot, and the
+  // slots after the first empty one are left empty. The choices are
+  // remembered for learn.
+  bool selectChunks(int* selection);
+
+  // Returns the probability with which the last selectChunks call drew
+  // the given candidate (-1 for the empty chunk) for the given slot.
+  double getSelectionProbability(int slot, int candidate) const;
+
+  // Changes the weights to make the last choices more likely in
+  // proportion to the provided TD error (less likely when it is
+  // negative). Returns false if there are no choices to learn from.
+  bool learn(double td_error);
+
+  // Writes/reads the weights of the network (the candidate weights
+  // followed by the bias weights).
+  bool writeWeights(ofstream& file_stream);
+  bool readWeights(ifstream& file_stream);
+
+  // Returns/sets the learning rate.
+  double getLearningRate() const;
+  bool setLearningRate(double value);
+
  private:
-  int	stubb;
+  int state_size; // Size of the state vectors.
+  int chunk_size; // Size of the chunk vectors.
+  int slots; // Number of slots (output units).
+  int input_size; // Size of a candidate's input vector.
+  double learning_rate; // Learning rate of both projections.
+  Layer* input_layer; // Input vector of one candidate (bound).
+  Layer* bias_layer; // Single unit whose activation is always 1.
+  Layer* output_layer; // One linear unit per slot.
+  BpFullForwardProjection* input_output_projection; // Candidate weights.
+  BpFullForwardProjection* bias_output_projection; // Bias weights.
+  SimpleLinearActivationFunction* slaf; // Activation of every unit.
+  int candidate_count; // Candidates last evaluated, with the empty one.
+  int candidate_capacity; // Room in the buffers below, in candidates.
+  double* candidate_inputs; // Input vector of each candidate.
+  double* scores; // Score of each candidate for each slot.
+  double* probabilities; // Probability of each slot's choices.
+  bool* taken; // Candidates already drawn for a slot.
+  int* choices; // Candidate drawn for each slot.
+  bool choices_valid; // Whether choices may be learned from.
+  double* slot_deltas; // Output deltas for one candidate, and
+  double** slot_delta_ptrs; // a pointer to each of them.
+
+  void init();
+  void dispose();
+  void copy(const ActorNetwork&);
+  void buildNetwork(int state, int chunk, int number_of_slots);
+  void reserveCandidates(int count);
+  void encodeCandidate(const FeatureVector& state,
+		       const FeatureVector& chunk, double* inputs);
 };
 
 #endif
@@ -50,39 +50,357 @@
  *****************************************************************************/
 
 #include <AggregateFeatureVector.h>
+#include <feature_kernels.h>
 #include <StateFeatureVector.h>
 #include <ChunkFeatureVector.h>
 #include <cstddef>
+#include <climits>
+#include <algorithm>
 #include <iostream>
-#include <cmath>
-
-enum coding_scheme {
-  CONCAT,
-  WM_CONJ,
-  COMPLETE_CONJ,
-  WM_STATE_CONJ
-};
-
-static coding_scheme afv_code = WM_CONJ;
 
 using namespace std;
 
 //#define WMTK_DEBUG
 #define USER_BASED_CONJUNCTION
 
-AggregateFeatureVector::AggregateFeatureVector() : FeatureVector() {
+// Returns base raised to the exponent, or -1 if that does not fit in an
+// int.
+static int integerPower(int base, int exponent) {
+  int result = 1;
+  for (int x = 0; x < exponent; x++) {
+    if (base != 0 && result > INT_MAX / base)
+      return -1;
+    result *= base;
+  }
+  return result;
+}
+
+// Fills dest with the products of one element from each chunk slot
+// (count slots of size elements each, stored one after the other). The
+// first slot varies slowest, then the last slot, then the one before
+// it, down to the second slot which varies fastest, and each product is
+// formed in slot order. (This is the layout the saved weights of the
+// conjunctive codes depend on.) The odometer holds count positions.
+static void chunkProduct(double* dest, int count, const double* chunks,
+			 int size, int* c) {
+  int x, y;
+  int total = 1;
+  double value;
+  bool carry;
+
+  for (x = 0; x < count; x++) {
+    c[x] = 0;
+    total *= size;
+  }
+
+  for (x = 0; x < total; x++) {
+    value = chunks[c[0]];
+    for (y = 1; y < count; y++)
+      value *= chunks[(y * size) + c[y]];
+    dest[x] = value;
+
+    carry = true;
+    for (y = 1; y < count && carry; y++) {
+      c[y]++;
+      if (c[y] < size)
+	carry = false;
+      else
+	c[y] = 0;
+    }
+
+    if (carry)
+      c[0]++;
+  }
+}
+
+// Contracts a dense tensor with one vector per mode (the first mode
+// varying slowest), one mode at a time. Rows of the tensor that meet a
+// zero element are skipped, and a mode of all zeros ends the
+// contraction early. Each work buffer holds the tensor size divided by
+// sizes[0] elements.
+static double contractTensor(const double* tensor, int modes,
+			     const double** factor, const int* sizes,
+			     double* work1, double* work2) {
+  int x, y, m;
+  int block = 1;
+  bool nonzero;
+  double f;
+  double value = 0.0;
+  const double* source = tensor;
+  const double* row;
+  double* target = work1;
+
+  for (m = 1; m < modes; m++)
+    block *= sizes[m];
+
+  for (m = 0; m < modes - 1; m++) {
+    fillValues(target, block, 0.0);
+
+    nonzero = false;
+    for (x = 0; x < sizes[m]; x++) {
+      f = factor[m][x];
+      if (f == 0.0)
+	continue;
+      nonzero = true;
+      row = source + (x * block);
+      for (y = 0; y < block; y++)
+	target[y] += f * row[y];
+    }
+    if (!nonzero)
+      return 0.0;
+
+    source = target;
+    target = (target == work1) ? work2 : work1;
+    block /= sizes[m + 1];
+  }
+
+  for (x = 0; x < sizes[modes - 1]; x++)
+    value += factor[modes - 1][x] * source[x];
+
+  return value;
+}
+
+// Mixes the bits of a hash key (the finalizer of MurmurHash3).
+static unsigned int mixHash(unsigned int key) {
+  key ^= key >> 16;
+  key *= 0x85ebca6bu;
+  key ^= key >> 13;
+  key *= 0xc2b2ae35u;
+  key ^= key >> 16;
+  return key;
+}
+
+static double dotProduct(const double* a, const double* b, int size) {
+  double value = 0.0;
+  for (int x = 0; x < size; x++)
+    value += a[x] * b[x];
+  return value;
+}
+
+void AggregateFeatureVector::init() {
   s_vector_size = 0;	// Initial values for empty vector
   c_vector_size = 0;
   number_of_chunks = 0;
   or_vector_size = 0;
+  scheme = WM_CONJ;
+  factored = false;
+  expand_kernel = NULL;
+  contract_kernel = NULL;
+  product_size = 0;
+  factors = NULL;
+  contract_work = NULL;
+  contract_work_size = 0;
+  contract_modes = NULL;
+  contract_sizes = NULL;
+  contract_mode_count = 0;
+  odometer = NULL;
+  hash_buckets = 0;
+  hash_work = NULL;
+  hash_keys = NULL;
+  hash_partial = NULL;
+  partial_sums = NULL;
+  partial_changed = NULL;
+  partial_sums_weights = NULL;
+  partial_sums_revision = 0;
+  binary_modes = NULL;
+  binary_partials = NULL;
+  binary_product = NULL;
+  binary_factors = false;
+  state_revision = 0;
+  contract_revision = 0;
+  state_sum_weights = NULL;
+  state_sum_revision = 0;
+  state_sum = 0.0;
+  state_delta = NULL;
+  pending_ranges = NULL;
+  pending_count = 0;
+  state_sum_age = 0;
+}
+
+void AggregateFeatureVector::dispose() {
+  if (factors != NULL)
+    delete [] factors;
+  if (contract_work != NULL)
+    delete [] contract_work;
+  if (contract_modes != NULL)
+    delete [] contract_modes;
+  if (contract_sizes != NULL)
+    delete [] contract_sizes;
+  if (odometer != NULL)
+    delete [] odometer;
+  if (hash_work != NULL)
+    delete [] hash_work;
+  if (hash_keys != NULL)
+    delete [] hash_keys;
+  if (hash_partial != NULL)
+    delete [] hash_partial;
+  if (partial_sums != NULL)
+    delete [] partial_sums;
+  if (partial_changed != NULL)
+    delete [] partial_changed;
+  if (binary_modes != NULL)
+    delete [] binary_modes;
+  if (binary_partials != NULL)
+    delete [] binary_partials;
+  if (state_delta != NULL)
+    delete [] state_delta;
+  if (pending_ranges != NULL)
+    delete [] pending_ranges;
+  init();
+}
+
+void AggregateFeatureVector::allocateFactors() {
+  int x;
+  int length = s_vector_size + (number_of_chunks * c_vector_size) +
+    or_vector_size;
+
+  factors = NULL;
+  contract_work = NULL;
+  contract_work_size = 0;
+  contract_modes = NULL;
+  contract_sizes = NULL;
+  contract_mode_count = 0;
+  odometer = NULL;
+  hash_work = NULL;
+  hash_keys = NULL;
+  hash_partial = NULL;
+  partial_sums = NULL;
+  partial_changed = NULL;
+  partial_sums_weights = NULL;
+  partial_sums_revision = 0;
+  binary_modes = NULL;
+  binary_partials = NULL;
+  binary_product = NULL;
+  binary_factors = false;
+  state_revision = 0;
+  contract_revision = 0;
+  state_sum_weights = NULL;
+  state_sum_revision = 0;
+  state_delta = NULL;
+  pending_ranges = NULL;
+  pending_count = 0;
+  state_sum_age = 0;
+
+  if (length > 0) {
+    factors = new double[length];
+    for (x = 0; x < length; x++)
+      factors[x] = WMTK_FV_MIN;
+  }
+
+  // The first contraction removes the slowest varying factor: the first
+  // chunk slot for WM_CONJ and the state for COMPLETE_CONJ.
+  if (number_of_chunks > 0 && !factored) {
+    if (scheme == WM_CONJ)
+      contract_work_size = product_size / c_vector_size;
+    if (scheme == COMPLETE_CONJ && s_vector_size > 0)
+      contract_work_size = product_size;
+  }
+
+  // The modes of the weight tensor, slowest varying first, are fixed
+  // views of the factors: the state (for COMPLETE_CONJ), the first
+  // chunk slot, then the others from the last to the second.
+  if (contract_work_size > 0) {
+    contract_work = new double[2 * contract_work_size];
+    contract_mode_count = number_of_chunks;
+    if (scheme == COMPLETE_CONJ)
+      contract_mode_count++;
+    contract_modes = new const double*[contract_mode_count];
+    contract_sizes = new int[contract_mode_count];
+
+    int m = 0;
+    if (scheme == COMPLETE_CONJ) {
+      contract_modes[m] = factors;
+      contract_sizes[m++] = s_vector_size;
+    }
+    contract_modes[m] = factors + s_vector_size;
+    contract_sizes[m++] = c_vector_size;
+    for (x = 1; x < number_of_chunks; x++) {
+      contract_modes[m] = factors + s_vector_size +
+	((number_of_chunks - x) * c_vector_size);
+      contract_sizes[m++] = c_vector_size;
+    }
+
+    // Products of binary features are binary only for 0/1 features.
+    if (WMTK_FV_MIN == 0.0 && WMTK_FV_MAX == 1.0) {
+      int size = contract_sizes[0];
+      binary_modes = new BinaryFeatureVector[contract_mode_count];
+      for (m = 0; m < contract_mode_count; m++)
+	binary_modes[m] = BinaryFeatureVector(contract_sizes[m]);
+      binary_product = binary_modes;
+      if (contract_mode_count > 1) {
+	binary_partials = new BinaryFeatureVector[contract_mode_count - 1];
+	for (m = 1; m < contract_mode_count; m++) {
+	  size *= contract_sizes[m];
+	  binary_partials[m - 1] = BinaryFeatureVector(size);
+	}
+	binary_product = binary_partials + (contract_mode_count - 2);
+      }
+    }
+  }
+
+  if (number_of_chunks > 0)
+    odometer = new int[number_of_chunks];
+
+  // The hashed code lists the nonzero features of each factor (where
+  // the factor is stored), then the count, position and start of each
+  // list.
+  if (hash_buckets > 0) {
+    hash_work = new int[length + (3 * hashModes())];
+    hash_keys = new unsigned int[hashModes() + 1];
+    hash_partial = new double[hashModes() + 1];
+  }
+
+  // The pairwise codes keep a copy of the factors they were last
+  // contracted with, a partial sum vector per slot pair, the value of
+  // each slot pair and the state term of each slot.
+  if (isPairwise() && !factored) {
+    partial_sums = new double[length - or_vector_size +
+			      (pairCount() * (c_vector_size + 1)) +
+			      number_of_chunks];
+    partial_changed = new bool[number_of_chunks + 1];
+  }
+
+  // CONCAT keeps the changes to the state since its share of the
+  // contraction was computed.
+  if (scheme == CONCAT && s_vector_size > 0) {
+    state_delta = new double[s_vector_size];
+    fillValues(state_delta, s_vector_size, 0.0);
+    pending_ranges = new int[2 * s_vector_size];
+  }
+}
+
+void AggregateFeatureVector::copy(const AggregateFeatureVector& src) {
+  int x;
+  int length = src.s_vector_size + (src.number_of_chunks * src.c_vector_size)
+    + src.or_vector_size;
+
+  s_vector_size = src.s_vector_size;
+  c_vector_size = src.c_vector_size;
+  number_of_chunks = src.number_of_chunks;
+  or_vector_size = src.or_vector_size;
+  scheme = src.scheme;
+  factored = src.factored;
+  product_size = src.product_size;
+  hash_buckets = src.hash_buckets;
+  allocateFactors();
+  selectKernels();
+  for (x = 0; x < length; x++)
+    factors[x] = src.factors[x];
+  state_revision = src.state_revision;
+  packFactors();
+}
+
+AggregateFeatureVector::AggregateFeatureVector() : FeatureVector() {
+  init();
   return;
 }
 
-AggregateFeatureVector::AggregateFeatureVector(int state_vector_size, int chunk_vector_size, int number_of_chunks_to_append) : FeatureVector(determineNecessarySize(state_vector_size, chunk_vector_size, number_of_chunks_to_append)) {
-  s_vector_size = 0; // Initial value for empty vector
-  c_vector_size = 0;
-  number_of_chunks = 0;
-  or_vector_size = 0;
+AggregateFeatureVector::AggregateFeatureVector(int state_vector_size, int chunk_vector_size, int number_of_chunks_to_append, CODING_SCHEME coding_scheme, bool factored_code, int hash_buckets_to_use) : FeatureVector(determineNecessarySize(state_vector_size, chunk_vector_size, number_of_chunks_to_append, coding_scheme, factored_code, hash_buckets_to_use)) {
+  init(); // Initial value for empty vector
+  scheme = coding_scheme;
+  factored = factored_code;
+  if (scheme == HASHED_CONJ && !factored)
+    hash_buckets = hash_buckets_to_use;
 
   // We defer error checking to the determineNecessarySize function. If it
   // determines that the arguments were OK, then the size of the vector will
@@ -99,18 +417,19 @@ AggregateFeatureVector::AggregateFeatureVector(int state_vector_size, int chunk_
       c_vector_size = 0;
       number_of_chunks = 0;
     }
+    else
+      product_size = integerPower(c_vector_size, number_of_chunks);
+
+    allocateFactors();
+    selectKernels();
   }
 
   return;
 }
 
 AggregateFeatureVector::AggregateFeatureVector(const AggregateFeatureVector& L) : FeatureVector(L) {
-  FeatureVector::operator=(L); // Use parent assignment
-
-  s_vector_size = L.s_vector_size;
-  c_vector_size = L.c_vector_size;
-  number_of_chunks = L.number_of_chunks;
-  or_vector_size = L.or_vector_size;
+  init();
+  copy(L);
   return;	
 }
 
@@ -118,49 +437,96 @@ AggregateFeatureVector& AggregateFeatureVector::operator=(const AggregateFeature
   if (this != &Rhs) {
     FeatureVector::operator=(Rhs); // Use parent assignment
 
-    s_vector_size = Rhs.s_vector_size;
-    c_vector_size = Rhs.c_vector_size;
-    number_of_chunks = Rhs.number_of_chunks;
-    or_vector_size = Rhs.or_vector_size;
+    dispose();
+    copy(Rhs);
   }
   return *this;
 }
 
+void AggregateFeatureVector::swap(AggregateFeatureVector& other) {
+  // Every buffer is owned through a pointer, so exchanging the pointers
+  // leaves the views into them (contract_modes, binary_product) valid.
+  FeatureVector::swap(other);
+  std::swap(s_vector_size, other.s_vector_size);
+  std::swap(c_vector_size, other.c_vector_size);
+  std::swap(number_of_chunks, other.number_of_chunks);
+  std::swap(or_vector_size, other.or_vector_size);
+  std::swap(scheme, other.scheme);
+  std::swap(factored, other.factored);
+  std::swap(expand_kernel, other.expand_kernel);
+  std::swap(contract_kernel, other.contract_kernel);
+  std::swap(product_size, other.product_size);
+  std::swap(factors, other.factors);
+  std::swap(contract_work, other.contract_work);
+  std::swap(contract_work_size, other.contract_work_size);
+  std::swap(contract_modes, other.contract_modes);
+  std::swap(contract_sizes, other.contract_sizes);
+  std::swap(contract_mode_count, other.contract_mode_count);
+  std::swap(odometer, other.odometer);
+  std::swap(hash_buckets, other.hash_buckets);
+  std::swap(hash_work, other.hash_work);
+  std::swap(hash_keys, other.hash_keys);
+  std::swap(hash_partial, other.hash_partial);
+  std::swap(partial_sums, other.partial_sums);
+  std::swap(partial_changed, other.partial_changed);
+  std::swap(partial_sums_weights, other.partial_sums_weights);
+  std::swap(partial_sums_revision, other.partial_sums_revision);
+  std::swap(binary_modes, other.binary_modes);
+  std::swap(binary_partials, other.binary_partials);
+  std::swap(binary_product, other.binary_product);
+  std::swap(binary_factors, other.binary_factors);
+  std::swap(state_revision, other.state_revision);
+  std::swap(contract_revision, other.contract_revision);
+  std::swap(state_sum_weights, other.state_sum_weights);
+  std::swap(state_sum_revision, other.state_sum_revision);
+  std::swap(state_sum, other.state_sum);
+  std::swap(state_delta, other.state_delta);
+  std::swap(pending_ranges, other.pending_ranges);
+  std::swap(pending_count, other.pending_count);
+  std::swap(state_sum_age, other.state_sum_age);
+}
+
+#if __cplusplus >= 201103L
+AggregateFeatureVector::AggregateFeatureVector(AggregateFeatureVector&& L) noexcept : FeatureVector() {
+  init();
+  swap(L);
+}
+
+AggregateFeatureVector& AggregateFeatureVector::operator=(AggregateFeatureVector&& Rhs) noexcept {
+  swap(Rhs);
+  return *this;
+}
+#endif
+
 AggregateFeatureVector::~AggregateFeatureVector() {
-  s_vector_size = 0;	// This function may not be necessary (or wanted).
-  c_vector_size = 0;
-  number_of_chunks = 0;
-  or_vector_size = 0;
+  dispose();
 }
 
 bool AggregateFeatureVector::updateFeatures(StateFeatureVector& state_vector, ChunkFeatureVector* chunk_vectors[],  FeatureVector& or_vector) {
-  int x, y, z; // Counters
-  int s;					// Variables for Full Conjunctive Coding
-  int* c = new int[number_of_chunks];
+  if (!setFactors(state_vector, chunk_vectors, or_vector))
+    return false;
+
+  return expandFactors();
+}
 
-  bool success = true; // Assume we will succeed
+bool AggregateFeatureVector::setFactors(StateFeatureVector& state_vector, ChunkFeatureVector* chunk_vectors[],  FeatureVector& or_vector) {
+  int x, z; // Counters
 
   // Basic check
-  if (getSize() == 0) {
-	delete [] c;
-	return false;
-  }
-  
+  if (getSize() == 0)
+    return false;
+
   // Check for vectors of the proper size
   if (&state_vector == NULL ||
       (state_vector.getSize() != s_vector_size &&
        c_vector_size == 0) || (chunk_vectors == NULL && s_vector_size == 0)
-      || (or_vector.getSize() != or_vector_size)) {
-	delete [] c;
-	return false;
-  }
+      || (or_vector.getSize() != or_vector_size))
+    return false;
 
   // Check chunk_vector sizes
   for (x = 0; x < number_of_chunks; x++)
-    if (chunk_vectors[x]->getSize() != c_vector_size) {
-      delete [] c;
+    if (chunk_vectors[x]->getSize() != c_vector_size)
       return false;
-    }
 
 #ifdef WMTK_DEBUG
   cout << "Aggregate Sizes Checked: CLEAN" << endl;
@@ -174,218 +540,702 @@ bool AggregateFeatureVector::updateFeatures(StateFeatureVector& state_vector, Ch
   cout << "OR Vector: " << or_vector << endl;
 #endif
 
-  // DEBUG - Output state and chunk vectors to check encodings.
-  /*
-    cout << "State Vector: ";
-    for (x = 0; x < state_vector.getSize(); x++)
-    cout << state_vector.getValue(x) << " ";
-    cout << endl;
-	
-    for (x = 0; x < number_of_chunks; x++) {
-    cout << "Chunk Vector #" << (x+1) << ": ";
-    for (y = 0; y < chunk_vectors[x]->getSize(); y++)
-    cout << chunk_vectors[x]->getValue(y) << " ";
-    cout << endl;
-    }
-  */
-
-  // Make conjunctive code...
-
-  if (afv_code == WM_STATE_CONJ) {
-
-    if (number_of_chunks > 0) {
-      // Conjunct Working Memory and State, but not individual chunks
-      FeatureVector chunks(c_vector_size * number_of_chunks);
-      for (x = 0; x < number_of_chunks; x++)
-	for (y = 0; y < c_vector_size; y++)
-	  chunks.setValue((x*c_vector_size) + y, chunk_vectors[x]->getValue(y));
-      
-      FeatureVector state_chunks(s_vector_size * chunks.getSize());
-      double value;
-      double value2;
-      for (x = 0; x < state_chunks.getSize(); x++)
-	for (y = 0; y < chunks.getSize(); y++) {
-	  value = 1.0;
-	  value2 = state_vector.getValue(x);
-	  value *= value2;
-	  value2 = chunks.getValue(y);
-	  value *= value2;
-	  success = success && state_chunks.setValue((x*chunks.getSize()) + y,
-						     value);
+  // Lay the factors out as state, chunk slots, then OR vector.
+  recordState(state_vector);
+  z = s_vector_size;
+
+  for (x = 0; x < number_of_chunks; x++) {
+    copyValues(factors + z, chunk_vectors[x]->getValues(), c_vector_size);
+    z += c_vector_size;
+  }
+
+  copyValues(factors + z, or_vector.getValues(), or_vector_size);
+
+  packFactors();
+
+  return true;
+}
+
+void AggregateFeatureVector::recordState(StateFeatureVector& state_vector) {
+  int x, first, count;
+  int z = state_vector.getSize();
+  const double* state = state_vector.getValues();
+
+  if (z != s_vector_size) {
+    // (Positions past the end of a short state vector read as -1.0, as
+    // from getValue.)
+    if (z > s_vector_size)
+      z = s_vector_size;
+    copyValues(factors, state, z);
+    fillValues(factors + z, s_vector_size - z, -1.0);
+    state_revision = 0;
+    dropStateSum();
+    return;
+  }
+
+  if (state_revision != 0 && state_vector.getRevision() == state_revision)
+    return;
+
+  int ranges = state_vector.getNumberOfChangedRanges();
+  if (state_revision == 0 || ranges < 0 ||
+      state_vector.getBaseRevision() != state_revision) {
+    copyValues(factors, state, s_vector_size);
+    dropStateSum();
+  }
+  else {
+    for (x = 0; x < ranges; x++) {
+      state_vector.getChangedRange(x, first, count);
+      if (state_sum_weights != NULL) {
+	if (pending_count == s_vector_size)
+	  dropStateSum();
+	else {
+	  for (z = first; z < first + count; z++)
+	    state_delta[z] += state[z] - factors[z];
+	  pending_ranges[2 * pending_count] = first;
+	  pending_ranges[(2 * pending_count) + 1] = count;
+	  pending_count++;
 	}
-      
-      // Fill conjunction part
-      for (x = 0; x < state_chunks.getSize(); x++)
-	setValue(x,state_chunks.getValue(x));
-      
-      // Concatenate OR vector
-      for (y = 0; y < or_vector.getSize(); y++, x++)
-	success = success && setValue(x,or_vector.getValue(y));
+      }
+      copyValues(factors + first, state + first, count);
     }
-    else {
-      clearVector();
+  }
+
+  state_revision = state_vector.getRevision();
+}
+
+void AggregateFeatureVector::dropStateSum() {
+  for (int x = 0; x < pending_count; x++)
+    fillValues(state_delta + pending_ranges[2 * x],
+	       pending_ranges[(2 * x) + 1], 0.0);
+  pending_count = 0;
+  state_sum_weights = NULL;
+}
+
+double AggregateFeatureVector::contractState(const double* weights) {
+  int x, first, count;
+
+  // The kept sum is recomputed once the changes added into it would
+  // cost as much, which also bounds its rounding error.
+  if (contract_revision == 0 || weights != state_sum_weights ||
+      contract_revision != state_sum_revision ||
+      state_sum_age > s_vector_size) {
+    dropStateSum();
+    state_sum = dotProduct(weights, factors, s_vector_size);
+    state_sum_weights = weights;
+    state_sum_revision = contract_revision;
+    state_sum_age = 0;
+    return state_sum;
+  }
+
+  for (x = 0; x < pending_count; x++) {
+    first = pending_ranges[2 * x];
+    count = pending_ranges[(2 * x) + 1];
+    state_sum += dotProduct(weights + first, state_delta + first, count);
+    fillValues(state_delta + first, count, 0.0);
+    state_sum_age += count;
+  }
+  pending_count = 0;
+
+  return state_sum;
+}
+
+bool AggregateFeatureVector::expandFactors() {
+  if (getSize() == 0 || factors == NULL)
+    return false;
+
+  return (this->*expand_kernel)();
+}
+
+double AggregateFeatureVector::contractWeights(const double* weights, unsigned long weights_revision) {
+  if (weights == NULL || getSize() == 0 || factors == NULL)
+    return 0.0;
+
+  contract_revision = weights_revision;
+
+  return (this->*contract_kernel)(weights);
+}
+
+// Coding scheme kernels. Each scheme has its own expansion and
+// contraction, chosen once by selectKernels, so neither the expansion
+// nor the search over working memory contents tests the scheme.
+
+template <>
+bool AggregateFeatureVector::expandCode<CONCAT>() {
+  double* values = getWritableValues();
+
+  // Fill in aggrgate vector with values from the state and chunk vectors
+  for (int x = 0; x < getSize(); x++)
+    values[x] = factors[x];
+
+  return true;
+}
+
+template <>
+double AggregateFeatureVector::contractCode<CONCAT>(const double* weights) {
+  if (contract_revision == 0 || s_vector_size == 0)
+    return dotProduct(weights, factors, getSize());
+
+  return contractState(weights) +
+    dotProduct(weights + s_vector_size, factors + s_vector_size,
+	       getSize() - s_vector_size);
+}
+
+template <>
+bool AggregateFeatureVector::expandCode<WM_STATE_CONJ>() {
+  int x, y, z; // Counters
+  double* values = getWritableValues();
+  const double* state = factors;
+  const double* chunks = factors + s_vector_size;
+  const double* or_values = chunks + (number_of_chunks * c_vector_size);
+  int chunks_size = number_of_chunks * c_vector_size;
+
+  if (number_of_chunks > 0) {
+    // Conjunct Working Memory and State, but not individual chunks
+    z = 0;
+    for (x = 0; x < s_vector_size; x++)
+      for (y = 0; y < chunks_size; y++)
+	values[z++] = state[x] * chunks[y];
+
+    // Concatenate OR vector
+    copyValues(values + z, or_values, or_vector_size);
+  }
+  else {
+    clearVector();
+  }
+
+  return true;
+}
+
+template <>
+double AggregateFeatureVector::contractCode<WM_STATE_CONJ>(const double* weights) {
+  int x;
+  const double* state = factors;
+  const double* chunks = factors + s_vector_size;
+  const double* or_values = chunks + (number_of_chunks * c_vector_size);
+  int chunks_size = number_of_chunks * c_vector_size;
+  double value = 0.0;
+
+  if (number_of_chunks == 0)
+    return 0.0;
+
+  // One block of weights per state feature
+  for (x = 0; x < s_vector_size; x++)
+    if (state[x] != 0.0)
+      value += state[x] * dotProduct(weights + (x * chunks_size), chunks,
+				     chunks_size);
+  weights += s_vector_size * chunks_size;
+
+  return value + dotProduct(weights, or_values, or_vector_size);
+}
+
+template <>
+bool AggregateFeatureVector::expandCode<COMPLETE_CONJ>() {
+  int x, y, z; // Counters
+  double* values = getWritableValues();
+  const double* state = factors;
+  const double* chunks = factors + s_vector_size;
+  const double* or_values = chunks + (number_of_chunks * c_vector_size);
+
+  if (number_of_chunks > 0) {
+    z = s_vector_size * product_size;
+    if (binary_factors)
+      binary_product->unpackValues(values);
+    else if (s_vector_size > 0) {
+      // Build the product in the last state block, then conjunct the
+      // state vector with it.
+      double* product = values + (z - product_size);
+      chunkProduct(product, number_of_chunks, chunks, c_vector_size,
+		   odometer);
+
+#ifdef WMTK_DEBUG
+      cout << "Filling with: ";
+      for (x = 0; x < product_size; x++)
+	cout << product[x] << " ";
+      cout << endl;
+#endif
+
+      for (x = 0; x < s_vector_size - 1; x++)
+	for (y = 0; y < product_size; y++)
+	  values[(x * product_size) + y] = state[x] * product[y];
+      for (y = 0; y < product_size; y++)
+	product[y] *= state[s_vector_size - 1];
     }
+
+    // Concatenate OR vector
+    copyValues(values + z, or_values, or_vector_size);
   }
-  
-  if (afv_code == COMPLETE_CONJ) {
-    if (number_of_chunks > 0) {
-      for (x = 0; x < number_of_chunks; x++)
-	c[x] = 0;
-      
-      int c_size = (int) pow((double) c_vector_size, number_of_chunks);
-      FeatureVector chunks((int) pow((double) c_vector_size, number_of_chunks));
-
-      if (number_of_chunks > 0) {
-	double value;
-	double value2;
-	for (x = 0; x < c_size; x++) {
-	  value = 1.0;
-	  value2 = chunk_vectors[0]->getValue(c[0]);
-	  value *= value2;
-	  for (y = 1; y < number_of_chunks; y++) {
-	    value2 = chunk_vectors[y]->getValue(c[y]);
-	    value *= value2;
-	  }
-	  success = success && chunks.setValue(x, value);
-	  
-	  bool carry = true;
-	  for (y = 1; y < number_of_chunks && carry; y++) {
-	    c[y]++;
-	    if (c[y] < c_vector_size)
-	      carry = false;
-	    else
-	      c[y] = 0;
-	  }
-	  
-	  if (carry)
-	    c[0]++;
-	}
-      }
-      
+  else {
+    clearVector();
+    copyValues(values + getSize() - or_vector_size, or_values,
+	       or_vector_size);
+  }
+
+  return true;
+}
+
+template <>
+double AggregateFeatureVector::contractCode<COMPLETE_CONJ>(const double* weights) {
+  const double* or_values = factors + s_vector_size +
+    (number_of_chunks * c_vector_size);
+  double value;
+
+  // Codes without a product of chunk vectors are simply expanded.
+  if (contract_work_size == 0) {
+    expandCode<COMPLETE_CONJ>();
+    return dotProduct(weights, getValues(), getSize());
+  }
+
+  if (binary_factors)
+    value = binary_product->sumWeights(weights);
+  else
+    value = contractTensor(weights, contract_mode_count, contract_modes,
+			   contract_sizes, contract_work,
+			   contract_work + contract_work_size);
+  weights += s_vector_size * product_size;
+
+  return value + dotProduct(weights, or_values, or_vector_size);
+}
+
+template <>
+bool AggregateFeatureVector::expandCode<WM_CONJ>() {
+  int z; // Counter
+  double* values = getWritableValues();
+  const double* state = factors;
+  const double* chunks = factors + s_vector_size;
+  const double* or_values = chunks + (number_of_chunks * c_vector_size);
+
+  if (number_of_chunks > 0) {
+    z = 0;
+    // Fill state vector
+    copyValues(values + z, state, s_vector_size);
+    z += s_vector_size;
+
+    // Fill conjunction part
+    if (binary_factors)
+      binary_product->unpackValues(values + z);
+    else
+      chunkProduct(values + z, number_of_chunks, chunks, c_vector_size,
+		   odometer);
+
 #ifdef WMTK_DEBUG
-      cout << "Filling with: " << chunks << endl;
+    cout << "Filling with: ";
+    for (int x = 0; x < product_size; x++)
+      cout << values[z + x] << " ";
+    cout << endl;
 #endif
+    z += product_size;
 
-      z = 0;
-      if (c_size == 0) {
-	for (x = 0; x < state_vector.getSize(); x++) {
-	  success = success && setValue(z++, state_vector.getValue(x));
-	}
-      }
-      else {
-	// Conjunct state vector
-	for (x = 0; x < state_vector.getSize(); x++) {
-	  for (y = 0; y < chunks.getSize(); y++)
-	    success = success && setValue(z++, state_vector.getValue(x) * chunks.getValue(y));
-	}
-      }
+    // Concatenate OR vector
+    copyValues(values + z, or_values, or_vector_size);
+  }
+  else {
+    clearVector();
+    copyValues(values + getSize() - or_vector_size, or_values,
+	       or_vector_size);
+  }
+
+  return true;
+}
+
+template <>
+double AggregateFeatureVector::contractCode<WM_CONJ>(const double* weights) {
+  const double* state = factors;
+  const double* or_values = factors + s_vector_size +
+    (number_of_chunks * c_vector_size);
+  double value;
+
+  // Codes without a product of chunk vectors are simply expanded.
+  if (contract_work_size == 0) {
+    expandCode<WM_CONJ>();
+    return dotProduct(weights, getValues(), getSize());
+  }
+
+  value = dotProduct(weights, state, s_vector_size);
+  weights += s_vector_size;
+  if (binary_factors)
+    value += binary_product->sumWeights(weights);
+  else
+    value += contractTensor(weights, contract_mode_count, contract_modes,
+			    contract_sizes, contract_work,
+			    contract_work + contract_work_size);
+  weights += product_size;
+
+  return value + dotProduct(weights, or_values, or_vector_size);
+}
+
+template <>
+bool AggregateFeatureVector::expandCode<PAIRWISE_CONJ>() {
+  return expandPairwise(false);
+}
+
+template <>
+double AggregateFeatureVector::contractCode<PAIRWISE_CONJ>(const double* weights) {
+  return contractPairwise(weights, false);
+}
+
+template <>
+bool AggregateFeatureVector::expandCode<PAIRWISE_STATE_CONJ>() {
+  return expandPairwise(true);
+}
+
+template <>
+double AggregateFeatureVector::contractCode<PAIRWISE_STATE_CONJ>(const double* weights) {
+  return contractPairwise(weights, true);
+}
+
+template <>
+bool AggregateFeatureVector::expandCode<HASHED_CONJ>() {
+  double* values = getWritableValues();
+  const double* or_values = factors + s_vector_size +
+    (number_of_chunks * c_vector_size);
+
+  // Hashed conjunctions, then the OR vector.
+  fillValues(values, hash_buckets, 0.0);
+  hashConjunctions(NULL, values, NULL);
+  copyValues(values + hash_buckets, or_values, or_vector_size);
+
+  return true;
+}
+
+template <>
+double AggregateFeatureVector::contractCode<HASHED_CONJ>(const double* weights) {
+  const double* or_values = factors + s_vector_size +
+    (number_of_chunks * c_vector_size);
 
-      // Concatenate OR vector
-      for (x = 0; x < or_vector.getSize(); x++)
-	success = success && setValue(z++,or_vector.getValue(x));
+  return hashConjunctions(weights, NULL, NULL) +
+    dotProduct(weights + hash_buckets, or_values, or_vector_size);
+}
+
+void AggregateFeatureVector::selectKernels() {
+  // The factored code is laid out as the concatenated code.
+  CODING_SCHEME code = factored ? CONCAT : scheme;
+
+  switch (code) {
+  case CONCAT:
+    expand_kernel = &AggregateFeatureVector::expandCode<CONCAT>;
+    contract_kernel = &AggregateFeatureVector::contractCode<CONCAT>;
+    break;
+  case WM_CONJ:
+    expand_kernel = &AggregateFeatureVector::expandCode<WM_CONJ>;
+    contract_kernel = &AggregateFeatureVector::contractCode<WM_CONJ>;
+    break;
+  case COMPLETE_CONJ:
+    expand_kernel = &AggregateFeatureVector::expandCode<COMPLETE_CONJ>;
+    contract_kernel = &AggregateFeatureVector::contractCode<COMPLETE_CONJ>;
+    break;
+  case WM_STATE_CONJ:
+    expand_kernel = &AggregateFeatureVector::expandCode<WM_STATE_CONJ>;
+    contract_kernel = &AggregateFeatureVector::contractCode<WM_STATE_CONJ>;
+    break;
+  case PAIRWISE_CONJ:
+    expand_kernel = &AggregateFeatureVector::expandCode<PAIRWISE_CONJ>;
+    contract_kernel = &AggregateFeatureVector::contractCode<PAIRWISE_CONJ>;
+    break;
+  case PAIRWISE_STATE_CONJ:
+    expand_kernel = &AggregateFeatureVector::expandCode<PAIRWISE_STATE_CONJ>;
+    contract_kernel =
+      &AggregateFeatureVector::contractCode<PAIRWISE_STATE_CONJ>;
+    break;
+  case HASHED_CONJ:
+    expand_kernel = &AggregateFeatureVector::expandCode<HASHED_CONJ>;
+    contract_kernel = &AggregateFeatureVector::contractCode<HASHED_CONJ>;
+    break;
+  }
+}
+
+bool AggregateFeatureVector::expandPairwise(bool state_terms) {
+  int x, i, j, a, b, z; // Counters
+  double* values = getWritableValues();
+  const double* state = factors;
+  const double* chunks = factors + s_vector_size;
+  const double* or_values = chunks + (number_of_chunks * c_vector_size);
+
+  z = 0;
+  copyValues(values + z, state, s_vector_size);
+  z += s_vector_size;
+
+  // Each slot pair, the later slot varying slowest
+  for (j = 1; j < number_of_chunks; j++)
+    for (i = 0; i < j; i++)
+      for (b = 0; b < c_vector_size; b++)
+	for (a = 0; a < c_vector_size; a++)
+	  values[z++] = chunks[(i * c_vector_size) + a] *
+	    chunks[(j * c_vector_size) + b];
+
+  // Each slot with the state vector
+  if (state_terms)
+    for (j = 0; j < number_of_chunks; j++)
+      for (x = 0; x < s_vector_size; x++)
+	for (a = 0; a < c_vector_size; a++)
+	  values[z++] = state[x] * chunks[(j * c_vector_size) + a];
+
+  // Concatenate OR vector
+  copyValues(values + z, or_values, or_vector_size);
+
+  return true;
+}
+
+void AggregateFeatureVector::packFactors() {
+  int m;
+
+  binary_factors = false;
+  if (binary_modes == NULL)
+    return;
+
+  for (m = 0; m < contract_mode_count; m++)
+    if (!binary_modes[m].packValues(contract_modes[m]))
+      return;
+
+  // Conjunct the modes in order, so the last varies fastest.
+  if (contract_mode_count > 1) {
+    binary_partials[0].makeConjunction(binary_modes[0], binary_modes[1]);
+    for (m = 2; m < contract_mode_count; m++)
+      binary_partials[m - 1].makeConjunction(binary_partials[m - 2],
+					     binary_modes[m]);
+  }
+
+  binary_factors = true;
+}
+
+bool AggregateFeatureVector::hasBinaryProduct() const {
+  return binary_factors;
+}
+
+bool AggregateFeatureVector::isFactored() const {
+  return factored;
+}
+
+bool AggregateFeatureVector::isPairwise() const {
+  return (scheme == PAIRWISE_CONJ || scheme == PAIRWISE_STATE_CONJ);
+}
+
+int AggregateFeatureVector::pairCount() const {
+  return (number_of_chunks * (number_of_chunks - 1)) / 2;
+}
+
+double AggregateFeatureVector::contractPairwise(const double* weights, bool with_state_terms) {
+  int x, i, j, a, b, p;
+  int pairs = pairCount();
+  int block = c_vector_size * c_vector_size;
+  const double* state = factors;
+  const double* chunks = factors + s_vector_size;
+  const double* or_values = chunks + (number_of_chunks * c_vector_size);
+  const double* slot;
+  const double* row;
+  double* saved;
+  double* saved_chunks = partial_sums;
+  double* saved_state = saved_chunks + (number_of_chunks * c_vector_size);
+  double* pair_sums = saved_state + s_vector_size;
+  double* pair_values = pair_sums + (pairs * c_vector_size);
+  double* state_terms = pair_values + pairs;
+  bool* state_changed = partial_changed + number_of_chunks;
+  double f;
+  double value;
 
+  if (partial_sums == NULL)
+    return 0.0;
+
+  // The partial sums are only reused with the same weights at the same
+  // revision.
+  bool reuse_sums = (contract_revision != 0 &&
+		     weights == partial_sums_weights &&
+		     contract_revision == partial_sums_revision);
+
+  // Find the slots (and state) that differ from the last contraction.
+  for (j = 0; j <= number_of_chunks; j++) {
+    if (j < number_of_chunks) {
+      slot = chunks + (j * c_vector_size);
+      saved = saved_chunks + (j * c_vector_size);
+      b = c_vector_size;
     }
     else {
-      clearVector();
-      for (x = getSize() - or_vector.getSize(), y = 0; x < getSize(); x++, y++)
-	success = success && setValue(x, or_vector.getValue(y));
+      slot = state;
+      saved = saved_state;
+      b = s_vector_size;
     }
+    partial_changed[j] = !reuse_sums;
+    for (x = 0; x < b && !partial_changed[j]; x++)
+      if (slot[x] != saved[x])
+	partial_changed[j] = true;
+    if (partial_changed[j])
+      for (x = 0; x < b; x++)
+	saved[x] = slot[x];
   }
+  partial_sums_weights = weights;
+  partial_sums_revision = contract_revision;
 
-  if (afv_code == WM_CONJ) {
-    if (number_of_chunks > 0) {
-      for (x = 0; x < number_of_chunks; x++)
-	c[x] = 0;
-      
-      int c_size = (int) pow((double) c_vector_size, number_of_chunks);
-      FeatureVector chunks((int) pow((double) c_vector_size, number_of_chunks));
-
-      if (number_of_chunks > 0) {
-	double value;
-	double value2;
-	for (x = 0; x < c_size; x++) {
-	  value = 1.0;
-	  value2 = chunk_vectors[0]->getValue(c[0]);
-	  value *= value2;
-	  for (y = 1; y < number_of_chunks; y++) {
-	    value2 = chunk_vectors[y]->getValue(c[y]);
-	    value *= value2;
-	  }
-	  success = success && chunks.setValue(x, value);
-	  
-	  bool carry = true;
-	  for (y = 1; y < number_of_chunks && carry; y++) {
-	    c[y]++;
-	    if (c[y] < c_vector_size)
-	      carry = false;
-	    else
-	      c[y] = 0;
-	  }
-	  
-	  if (carry)
-	    c[0]++;
+  value = dotProduct(weights, state, s_vector_size);
+  weights += s_vector_size;
+
+  // The weights of a pair times its later slot only change with that
+  // slot; the pair's value only changes with either slot.
+  for (j = 1, p = 0; j < number_of_chunks; j++) {
+    slot = chunks + (j * c_vector_size);
+    for (i = 0; i < j; i++, p++) {
+      if (partial_changed[j]) {
+	for (a = 0; a < c_vector_size; a++)
+	  pair_sums[(p * c_vector_size) + a] = 0.0;
+	for (b = 0; b < c_vector_size; b++) {
+	  f = slot[b];
+	  if (f == 0.0)
+	    continue;
+	  row = weights + (p * block) + (b * c_vector_size);
+	  for (a = 0; a < c_vector_size; a++)
+	    pair_sums[(p * c_vector_size) + a] += f * row[a];
 	}
       }
-      
-#ifdef WMTK_DEBUG
-      cout << "Filling with: " << chunks << endl;
-#endif
+      if (partial_changed[i] || partial_changed[j])
+	pair_values[p] = dotProduct(chunks + (i * c_vector_size),
+				    pair_sums + (p * c_vector_size),
+				    c_vector_size);
+      value += pair_values[p];
+    }
+  }
+  weights += pairs * block;
 
-      z = 0;
-      // Fill state vector
-      for (x = 0; x < state_vector.getSize(); x++) {
-	success = success && setValue(z++, state_vector.getValue(x));
+  // The state term of a slot only changes with the slot or the state.
+  if (with_state_terms) {
+    for (j = 0; j < number_of_chunks; j++) {
+      if (partial_changed[j] || *state_changed) {
+	slot = chunks + (j * c_vector_size);
+	row = weights + (j * s_vector_size * c_vector_size);
+	state_terms[j] = 0.0;
+	for (x = 0; x < s_vector_size; x++) {
+	  f = state[x];
+	  if (f != 0.0)
+	    state_terms[j] += f * dotProduct(row + (x * c_vector_size), slot,
+					     c_vector_size);
+	}
       }
+      value += state_terms[j];
+    }
+    weights += number_of_chunks * s_vector_size * c_vector_size;
+  }
+
+  value += dotProduct(weights, or_values, or_vector_size);
+
+  return value;
+}
+
+int AggregateFeatureVector::getHashBuckets() const {
+  return hash_buckets;
+}
+
+double AggregateFeatureVector::getHashCollisionRate() {
+  if (hash_work == NULL)
+    return 0.0;
+
+  int x;
+  int active = 0;
+  int colliding = 0;
+  int* counts = new int[hash_buckets];
+
+  for (x = 0; x < hash_buckets; x++)
+    counts[x] = 0;
+  hashConjunctions(NULL, NULL, counts);
+
+  for (x = 0; x < hash_buckets; x++) {
+    active += counts[x];
+    if (counts[x] > 1)
+      colliding += counts[x];
+  }
 
-      // Fill conjunction part
-      for (x = 0; x < chunks.getSize(); x++)
-	success = success && setValue(z++,chunks.getValue(x));
+  delete [] counts;
 
-      // Concatenate OR vector
-      for (x = 0; x < or_vector.getSize(); x++)
-	success = success && setValue(z++,or_vector.getValue(x));
+  if (active == 0)
+    return 0.0;
+  return ((double) colliding) / ((double) active);
+}
+
+int AggregateFeatureVector::hashModes() const {
+  return ((s_vector_size > 0) ? 1 : 0) + number_of_chunks;
+}
+
+double AggregateFeatureVector::hashConjunctions(const double* weights, double* values, int* counts) {
+  int x, m;
+  int modes = hashModes();
+  int length = s_vector_size + (number_of_chunks * c_vector_size);
+  int* features = hash_work;
+  int* count = hash_work + length;
+  int* position = count + modes;
+  int* start = position + modes;
+  int size;
+  int bucket;
+  unsigned int key;
+  double product;
+  double value = 0.0;
 
+  if (modes == 0 || hash_work == NULL)
+    return 0.0;
+
+  // List the nonzero features of each factor: the state (if any), then
+  // each chunk slot. A factor without any means no conjunction is
+  // active.
+  for (m = 0; m < modes; m++) {
+    if (m == 0 && s_vector_size > 0) {
+      start[m] = 0;
+      size = s_vector_size;
     }
     else {
-      clearVector();
-      for (x = getSize() - or_vector.getSize(), y = 0; x < getSize(); x++, y++)
-	success = success && setValue(x, or_vector.getValue(y));
+      start[m] = s_vector_size +
+	((m - ((s_vector_size > 0) ? 1 : 0)) * c_vector_size);
+      size = c_vector_size;
     }
+    count[m] = 0;
+    position[m] = 0;
+    for (x = start[m]; x < start[m] + size; x++)
+      if (factors[x] != 0.0)
+	features[start[m] + count[m]++] = x;
+    if (count[m] == 0)
+      return 0.0;
   }
 
-  if (afv_code == CONCAT) {
+  // Walk the conjunctions, last factor fastest, keeping the hash and the
+  // product of every prefix so each step only redoes the factors that
+  // changed.
+  hash_keys[0] = 2166136261u;
+  hash_partial[0] = 1.0;
+  m = 0;
+  for (;;) {
+    for (; m < modes; m++) {
+      x = features[start[m] + position[m]];
+      hash_keys[m + 1] = mixHash((hash_keys[m] * 0x9e3779b1u) ^
+				 ((unsigned int) x));
+      hash_partial[m + 1] = hash_partial[m] * factors[x];
+    }
 
-    // Fill in aggrgate vector with values from the state and chunk vectors
-    z = 0; // Counter for AggregateVector position
-    for (x = 0; x < state_vector.getSize(); x++)
-      success = success && setValue(z++, state_vector.getValue(x));
-    
-    for (x = 0; x < number_of_chunks; x++)
-      for (y = 0; y < chunk_vectors[x]->getSize(); y++)
-	success = success && setValue(z++, chunk_vectors[x]->getValue(y));
+    // The low bit gives the sign and the rest the bucket.
+    key = hash_keys[modes];
+    bucket = (int) ((key >> 1) % ((unsigned int) hash_buckets));
+    product = (key & 1u) ? -hash_partial[modes] : hash_partial[modes];
+    if (weights != NULL)
+      value += weights[bucket] * product;
+    if (values != NULL)
+      values[bucket] += product;
+    if (counts != NULL)
+      counts[bucket]++;
 
-    for (x = 0; x < or_vector.getSize(); x++)
-      success = success && setValue(z++, or_vector.getValue(x));
+    for (m = modes - 1; m >= 0; m--) {
+      if (++position[m] < count[m])
+	break;
+      position[m] = 0;
+    }
+    if (m < 0)
+      break;
   }
 
-  // DEBUG
-  /*
-    cout << "Final Vector: ";
-    for (x = 0; x < getSize(); x++)
-    cout << getValue(x) << " ";
-    cout << endl;
-  */
+  return value;
+}
 
-  #ifdef WMTK_DEBUG
-  cout << "Result: " << *(this) << endl;
-  #endif
+CODING_SCHEME AggregateFeatureVector::getCodingScheme() const {
+  return scheme;
+}
 
-  // Return 'and' of all of the setValue calls. If one failed, we will know.
-  delete [] c;
-  return success;
+bool AggregateFeatureVector::conjunctsState() const {
+  return scheme == COMPLETE_CONJ;
 }
 
-int AggregateFeatureVector::determineNecessarySize(int state_size, int chunk_size, int num_chunks) {
+int AggregateFeatureVector::determineNecessarySize(int state_size, int chunk_size, int num_chunks, CODING_SCHEME code, bool factored_code, int buckets) {
   if (state_size < 0 || chunk_size < 0 || num_chunks < 0)
     return 0;
 
@@ -397,11 +1247,31 @@ int AggregateFeatureVector::determineNecessarySize(int state_size, int chunk_siz
   // or a dummy list of ChunkFeatureVectors then this feature becomes
   // usable.
 
-  // Concatenated coding
-  if (afv_code == CONCAT)
+  // Concatenated coding (also the layout of the factored code)
+  if (code == CONCAT || factored_code)
     return (state_size + (num_chunks * chunk_size) + chunk_size);
 
-  if (afv_code == WM_STATE_CONJ) {
+  // Hashed coding: the buckets and the OR vector, whatever the sizes
+  if (code == HASHED_CONJ) {
+    if (buckets < 1 || buckets > INT_MAX - chunk_size)
+      return 0;
+    return buckets + chunk_size;
+  }
+
+  if (code == PAIRWISE_CONJ || code == PAIRWISE_STATE_CONJ) {
+    // State, each pair of chunk slots, and (for PAIRWISE_STATE_CONJ)
+    // the state with each chunk slot
+    double pairwise = (double) state_size + chunk_size +
+      ((double) num_chunks * (num_chunks - 1) / 2.0) *
+      chunk_size * chunk_size;
+    if (code == PAIRWISE_STATE_CONJ)
+      pairwise += (double) num_chunks * state_size * chunk_size;
+    if (pairwise > INT_MAX)
+      return 0;
+    return (int) pairwise;
+  }
+
+  if (code == WM_STATE_CONJ) {
     // This for WM/State conjunction
     if (state_size == 0 && (chunk_size == 0 || num_chunks == 0))
       return chunk_size;
@@ -409,31 +1279,41 @@ int AggregateFeatureVector::determineNecessarySize(int state_size, int chunk_siz
       return (chunk_size * num_chunks) + chunk_size;
     if (chunk_size == 0 || num_chunks == 0)
       return state_size;
+    if ((double) state_size * chunk_size * num_chunks + chunk_size > INT_MAX)
+      return 0;
     return (state_size * (chunk_size *  num_chunks)) + chunk_size;
   }
 
-  if (afv_code == COMPLETE_CONJ) {
+  // Size of the product of the chunk vectors; a code too large for an
+  // int gives an empty vector rather than an overflowed size.
+  int product = integerPower(chunk_size, num_chunks);
+  if (product < 0)
+    return 0;
+
+  if (code == COMPLETE_CONJ) {
     // All of these are for complete conjunctive coding
     if (state_size == 0 && (chunk_size == 0 || num_chunks == 0))
       return chunk_size;
     if (state_size == 0)
-      return ((int) pow((double) chunk_size, num_chunks)) + chunk_size;
+      return (product > INT_MAX - chunk_size) ? 0 : product + chunk_size;
     if (chunk_size == 0 || num_chunks == 0)
       return state_size + chunk_size;
-    return (state_size * (int) pow((double) chunk_size, num_chunks)) +
-      chunk_size;
+    if ((double) state_size * product + chunk_size > INT_MAX)
+      return 0;
+    return (state_size * product) + chunk_size;
   }
 
-  if (afv_code == WM_CONJ) {
+  if (code == WM_CONJ) {
     // Conjunct just the WM contents
     if (state_size == 0 && (chunk_size == 0 || num_chunks == 0))
       return chunk_size;
     if (state_size == 0)
-      return ((int) pow((double) chunk_size, num_chunks)) + chunk_size;
+      return (product > INT_MAX - chunk_size) ? 0 : product + chunk_size;
     if (chunk_size == 0 || num_chunks == 0)
       return state_size + chunk_size;
-    return (state_size + (int) pow((double) chunk_size, num_chunks)) +
-      chunk_size;
+    if ((double) state_size + product + chunk_size > INT_MAX)
+      return 0;
+    return (state_size + product) + chunk_size;
   }
   return 0;
 }
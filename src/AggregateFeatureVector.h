@@ -35,16 +35,70 @@
  * JLP - 5/6/04 12:45AM
  * 		Added size computation function for constructor use.
  *
+ * The state, chunk and OR vectors (the factors of the aggregate) are
+ * also kept in a compact form, so that the value of the conjunctive
+ * codes under a linear weight vector can be computed by contracting
+ * the weights one chunk slot at a time, without building the
+ * product vector.
+ *
+ * The pairwise codes conjunct only each pair of chunk slots (and, for
+ * PAIRWISE_STATE_CONJ, the state with each slot), so their size grows
+ * with the square of the number of chunks rather than exponentially.
+ * Their contraction keeps the partial sums of each slot and reuses
+ * them for the slots that did not change since the previous call with
+ * the same weights, as happens between neighbouring combinations of
+ * working memory contents.
+ *
+ * With a hashed code, every conjunction of one state feature with one
+ * feature from each chunk slot is hashed (with a sign) into a fixed
+ * number of buckets, so the size of the vector does not grow with the
+ * number or size of the chunk vectors. Only the conjunctions whose
+ * features are all nonzero are visited.
+ *
+ * When the factors of the product in WM_CONJ and COMPLETE_CONJ are all
+ * binary, they are also packed into BinaryFeatureVectors and the
+ * product is built a word at a time, so that the code is expanded by
+ * writing only its set features and contracted by summing only their
+ * weights.
+ *
+ * The state part of the factors is refreshed only where the state vector
+ * changed since it was last recorded (see setFactors), and for CONCAT
+ * the state's share of the contraction is kept and adjusted for those
+ * changes while the weights stay the same, so the cost of the state part
+ * follows what changed rather than the size of the state vector.
+ *
  *****************************************************************************/
 
 #ifndef WMTK_AGGREGATE_FEATURE_VECTOR_H
 #define WMTK_AGGREGATE_FEATURE_VECTOR_H
 
 #include <FeatureVector.h>
+#include <BinaryFeatureVector.h>
 
 class StateFeatureVector;
 class ChunkFeatureVector;
 
+// Enumeration of coding schemes.
+// Each scheme decides how the state, chunk and OR vectors are combined
+// into the aggregate vector; the OR vector always comes last. CONCAT
+// concatenates the vectors. WM_CONJ concatenates the state vector with
+// the product of the chunk vectors, and COMPLETE_CONJ takes the product
+// of the state vector with all of the chunk vectors. WM_STATE_CONJ
+// takes the product of the state vector with the concatenated chunk
+// vectors. PAIRWISE_CONJ concatenates the state vector with the product
+// of each pair of chunk vectors, and PAIRWISE_STATE_CONJ adds the
+// product of the state vector with each chunk vector. HASHED_CONJ
+// hashes the complete conjunction into a fixed number of buckets.
+enum CODING_SCHEME {
+  CONCAT,
+  WM_CONJ,
+  COMPLETE_CONJ,
+  WM_STATE_CONJ,
+  PAIRWISE_CONJ,
+  PAIRWISE_STATE_CONJ,
+  HASHED_CONJ
+};
+
 class AggregateFeatureVector : public FeatureVector {
 
  public:
@@ -56,10 +110,23 @@ class AggregateFeatureVector : public FeatureVector {
   // Constructor
   // Creates a real vector of the necessary size to handle the
   // concatenation of the number of specified chunks with the specified
-  // state vector size.
+  // state vector size, using the specified coding scheme.
+  //
+  // If factored_code is set, the vector holds only the factors of the
+  // code (the state, chunk and OR vectors, one after the other) for a
+  // critic that computes the conjunction itself (see the
+  // LOW_RANK_ENGINE of the CriticNetwork class), so no storage is spent
+  // on the product of the chunk vectors.
+  //
+  // The HASHED_CONJ scheme (without factored_code) hashes the
+  // conjunctions of the state and chunk vectors into hash_buckets
+  // buckets, which must be positive.
   AggregateFeatureVector(int state_vector_size,
 			 int chunk_vector_size,
-			 int number_of_chunks_to_append);
+			 int number_of_chunks_to_append,
+			 CODING_SCHEME coding_scheme = WM_CONJ,
+			 bool factored_code = false,
+			 int hash_buckets = 0);
 
   // Copy-constructor
   AggregateFeatureVector(const AggregateFeatureVector&);
@@ -67,6 +134,18 @@ class AggregateFeatureVector : public FeatureVector {
   // Assignment Operator
   AggregateFeatureVector& operator=(const AggregateFeatureVector&);
 
+  // Exchanges the contents of this vector with those of the provided
+  // one, without copying or allocating.
+  void swap(AggregateFeatureVector&);
+
+#if __cplusplus >= 201103L
+  // Move-Constructor and Move-Assignment
+  // Take over the contents of the source, which is left valid but
+  // unspecified.
+  AggregateFeatureVector(AggregateFeatureVector&&) noexcept;
+  AggregateFeatureVector& operator=(AggregateFeatureVector&&) noexcept;
+#endif
+
   // Destructor
   ~AggregateFeatureVector();
 
@@ -83,6 +162,58 @@ class AggregateFeatureVector : public FeatureVector {
 		      ChunkFeatureVector* chunk_vectors[],
 		      FeatureVector& or_vector);
 
+  // Records the state, chunk and OR vectors without building the
+  // aggregate vector itself (updateFeatures is setFactors followed by
+  // expandFactors). The aggregate's elements are stale until
+  // expandFactors is called. The state is not copied again if it has the
+  // revision last recorded, and only its changed ranges are copied if it
+  // was updated from that revision and knows them (see
+  // StateFeatureVector::getNumberOfChangedRanges). Returns false if the
+  // vectors do not fit.
+  bool setFactors(StateFeatureVector& state_vector,
+		  ChunkFeatureVector* chunk_vectors[],
+		  FeatureVector& or_vector);
+
+  // Builds the aggregate vector from the last recorded factors.
+  bool expandFactors();
+
+  // Returns the dot product of the provided weights (one per element
+  // of the aggregate vector) with the aggregate vector of the last
+  // recorded factors. For the conjunctive codes the weights are
+  // contracted with one chunk vector at a time, skipping zero chunk
+  // features, so the product vector is never built. For the hashed
+  // code the weights of the buckets hit by nonzero conjunctions are
+  // read directly. If weights_revision is not zero, parts of the
+  // contraction are kept and reused for as long as the same weights are
+  // given with the same revision, so the revision must change whenever
+  // the weights do: for the pairwise codes, the partial sums of the
+  // slots unchanged since the previous call, and for CONCAT, the
+  // contraction with the state (adjusted for the changes to the state).
+  double contractWeights(const double* weights,
+			 unsigned long weights_revision = 0);
+
+  // Returns true if the vector holds only the factors of the code.
+  bool isFactored() const;
+
+  // Returns the number of hash buckets (zero if the code is not hashed).
+  int getHashBuckets() const;
+
+  // Returns the fraction of the nonzero conjunctions of the last
+  // recorded factors that share their bucket with another one (zero if
+  // the code is not hashed or there are no such conjunctions).
+  double getHashCollisionRate();
+
+  // Returns the coding scheme of the vector.
+  CODING_SCHEME getCodingScheme() const;
+
+  // Returns true if the product of the last recorded factors is held
+  // packed (all of its factors were binary; see above).
+  bool hasBinaryProduct() const;
+
+  // Returns true if the conjunctive code in use includes the state
+  // vector in the conjunction (COMPLETE_CONJ).
+  bool conjunctsState() const;
+
  private:
   int s_vector_size; // The size of the state vector that will be
   // provided.
@@ -93,11 +224,102 @@ class AggregateFeatureVector : public FeatureVector {
   int or_vector_size; // The size of the OR vector - will be the same
 		      // as the c_vector_size except for CONJUNCTIVE
 		      // codes where c_vector_size = 0
+  CODING_SCHEME scheme; // How the vectors are combined.
+  bool factored; // Whether only the factors are held (see above).
+  bool (AggregateFeatureVector::*expand_kernel)(); // The scheme's kernels
+  double (AggregateFeatureVector::*contract_kernel)(const double*);
+  int product_size; // Size of the product of the chunk vectors.
+  double* factors; // State, chunk and OR vectors, concatenated.
+  double* contract_work; // Two buffers for partial contractions.
+  int contract_work_size; // Size of each of those buffers.
+  const double** contract_modes; // Factor of each mode of the weights.
+  int* contract_sizes; // Size of each mode of the weights.
+  int contract_mode_count; // Number of modes of the weights.
+  int* odometer; // Chunk slot positions for building the product.
+  int hash_buckets; // Number of buckets of the hashed code.
+  int* hash_work; // Nonzero feature lists, their counts and positions.
+  unsigned int* hash_keys; // Hash of each prefix of a conjunction.
+  double* hash_partial; // Product of each prefix of a conjunction.
+  double* partial_sums; // Partial sums of the pairwise contraction.
+  bool* partial_changed; // Slots (then state) changed since the last one.
+  const double* partial_sums_weights; // Weights and revision that
+  unsigned long partial_sums_revision; // partial_sums were computed
+  // with (NULL if none).
+  BinaryFeatureVector* binary_modes; // Packed factors of the product, and
+  BinaryFeatureVector* binary_partials; // the products of the first 2,
+  // 3, ... of those.
+  const BinaryFeatureVector* binary_product; // The whole product.
+  bool binary_factors; // Whether the factors packed (were binary).
+  unsigned long state_revision; // Revision of the state in the factors
+  // (0 if not known).
+  unsigned long contract_revision; // Revision of the weights being
+  // contracted (0 if not known).
+  const double* state_sum_weights; // Weights and revision that state_sum
+  unsigned long state_sum_revision; // was computed with (NULL if none),
+  double state_sum; // the contraction of the state with them,
+  double* state_delta; // changes to the state since, at each element,
+  int* pending_ranges; // in these ranges (first element and length),
+  int pending_count; // of which there are this many,
+  int state_sum_age; // and the elements added in since it was computed.
+
   // Determines the size that an aggregate vector needs to be and checks
   // for inconsistencies in the provided sizes.
   int determineNecessarySize(int state_size,
 			     int chunk_size,
-			     int num_chunks);
+			     int num_chunks,
+			     CODING_SCHEME code,
+			     bool factored_code,
+			     int buckets);
+
+  // The expansion and contraction of each coding scheme (specialized
+  // for each one), and the choice of those for this vector's scheme.
+  template <CODING_SCHEME code> bool expandCode();
+  template <CODING_SCHEME code> double contractCode(const double* weights);
+  void selectKernels();
+
+  // Copies the state into the factors, only where it changed if
+  // possible.
+  void recordState(StateFeatureVector& state_vector);
+
+  // Discards the state's share of the contraction.
+  void dropStateSum();
+
+  // Returns the contraction of the weights with the state, from the kept
+  // one if possible.
+  double contractState(const double* weights);
+
+  // Builds the pairwise code (with or without the state terms).
+  bool expandPairwise(bool state_terms);
+
+  // Returns true if the pairwise code is in use.
+  bool isPairwise() const;
+
+  // Returns the number of pairs of chunk slots.
+  int pairCount() const;
+
+  // Contracts the weights with the pairwise code (see contractWeights).
+  double contractPairwise(const double* weights, bool with_state_terms);
+
+  // Packs the factors of the product and builds the packed product if
+  // they are all binary, recording whether they were.
+  void packFactors();
+
+  // Returns the number of factors conjoined by the hashed code.
+  int hashModes() const;
+
+  // Visits every conjunction of nonzero features of the hashed code. For
+  // each one, the signed product is weighted by its bucket's weight and
+  // summed into the result (if weights is given), added into its bucket
+  // of values (if values is given), and its bucket is counted (if
+  // counts is given).
+  double hashConjunctions(const double* weights, double* values,
+			  int* counts);
+
+  // Contructor and Destructor utility functions
+  void init();
+  void dispose();
+  void copy(const AggregateFeatureVector&);
+  void allocateFactors();
 };
 
 #endif
@@ -0,0 +1,307 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+/******************************************************************************
+ * BinaryFeatureVector.cpp
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * Vector of binary features packed 64 to a word, with word-at-a-time
+ * logical codes and sums of weights over the set features.
+ *
+ *****************************************************************************/
+
+#include <BinaryFeatureVector.h>
+#include <cstddef>
+#include <algorithm>
+
+// Returns the position of the lowest set bit of a nonzero word.
+static inline int lowestBit(BinaryWord word) {
+#ifdef __GNUC__
+  return __builtin_ctzll(word);
+#else
+  int x = 0;
+  while ((word & 1) == 0) {
+    word >>= 1;
+    x++;
+  }
+  return x;
+#endif
+}
+
+// Returns the number of set bits of a word.
+static inline int bitCount(BinaryWord word) {
+#ifdef __GNUC__
+  return __builtin_popcountll(word);
+#else
+  int x = 0;
+  for (; word != 0; word &= word - 1)
+    x++;
+  return x;
+#endif
+}
+
+void BinaryFeatureVector::init() {
+  words = NULL;
+  size = 0;
+  word_count = 0;
+}
+
+void BinaryFeatureVector::dispose() {
+  if (words != NULL)
+    delete [] words;
+  init();
+}
+
+void BinaryFeatureVector::copy(const BinaryFeatureVector& src) {
+  size = src.size;
+  word_count = src.word_count;
+  if (word_count > 0) {
+    words = new BinaryWord[word_count];
+    for (int x = 0; x < word_count; x++)
+      words[x] = src.words[x];
+  }
+}
+
+BinaryFeatureVector::BinaryFeatureVector() {
+  init();
+}
+
+BinaryFeatureVector::BinaryFeatureVector(int vector_size) {
+  init();
+
+  if (vector_size < 1)
+    return;
+
+  size = vector_size;
+  word_count = (size + WMTK_BFV_WORD_BITS - 1) / WMTK_BFV_WORD_BITS;
+  words = new BinaryWord[word_count];
+  clearVector();
+}
+
+BinaryFeatureVector::BinaryFeatureVector(const BinaryFeatureVector& L) {
+  init();
+  copy(L);
+}
+
+BinaryFeatureVector& BinaryFeatureVector::operator=(const BinaryFeatureVector& Rhs) {
+  if (this != &Rhs) {
+    dispose();
+    copy(Rhs);
+  }
+  return *this;
+}
+
+void BinaryFeatureVector::swap(BinaryFeatureVector& other) {
+  std::swap(words, other.words);
+  std::swap(size, other.size);
+  std::swap(word_count, other.word_count);
+}
+
+#if __cplusplus >= 201103L
+BinaryFeatureVector::BinaryFeatureVector(BinaryFeatureVector&& L) noexcept {
+  init();
+  swap(L);
+}
+
+BinaryFeatureVector& BinaryFeatureVector::operator=(BinaryFeatureVector&& Rhs) noexcept {
+  swap(Rhs);
+  return *this;
+}
+#endif
+
+BinaryFeatureVector::~BinaryFeatureVector() {
+  dispose();
+}
+
+int BinaryFeatureVector::getSize() const {
+  return size;
+}
+
+int BinaryFeatureVector::getWordCount() const {
+  return word_count;
+}
+
+const BinaryWord* BinaryFeatureVector::getWords() const {
+  return words;
+}
+
+double BinaryFeatureVector::getValue(int position) const {
+  if (position < 0 || position >= size)
+    return -1.0;
+
+  if ((words[position / WMTK_BFV_WORD_BITS] >>
+       (position % WMTK_BFV_WORD_BITS)) & 1)
+    return WMTK_FV_MAX;
+  return WMTK_FV_MIN;
+}
+
+bool BinaryFeatureVector::setValue(int position, double value) {
+  if (position < 0 || position >= size ||
+      (value != WMTK_FV_MIN && value != WMTK_FV_MAX))
+    return false;
+
+  BinaryWord bit = ((BinaryWord) 1) << (position % WMTK_BFV_WORD_BITS);
+  if (value == WMTK_FV_MAX)
+    words[position / WMTK_BFV_WORD_BITS] |= bit;
+  else
+    words[position / WMTK_BFV_WORD_BITS] &= ~bit;
+
+  return true;
+}
+
+void BinaryFeatureVector::clearVector() {
+  for (int x = 0; x < word_count; x++)
+    words[x] = 0;
+}
+
+bool BinaryFeatureVector::packVector(const FeatureVector& vector) {
+  if (vector.getSize() != size || size == 0)
+    return false;
+
+  return packValues(vector.getValues());
+}
+
+bool BinaryFeatureVector::packValues(const double* values) {
+  if (values == NULL || size == 0)
+    return false;
+
+  int x, y, z;
+  BinaryWord word;
+
+  for (x = 0, z = 0; x < word_count; x++) {
+    word = 0;
+    for (y = 0; y < WMTK_BFV_WORD_BITS && z < size; y++, z++) {
+      if (values[z] == WMTK_FV_MAX)
+	word |= ((BinaryWord) 1) << y;
+      else if (values[z] != WMTK_FV_MIN)
+	return false;
+    }
+    words[x] = word;
+  }
+
+  return true;
+}
+
+bool BinaryFeatureVector::unpackVector(FeatureVector& vector) const {
+  if (vector.getSize() != size || size == 0)
+    return false;
+
+  int x;
+  BinaryWord word;
+
+  vector.clearVector();
+  for (x = 0; x < word_count; x++)
+    for (word = words[x]; word != 0; word &= word - 1)
+      vector.setValue((x * WMTK_BFV_WORD_BITS) + lowestBit(word),
+		      WMTK_FV_MAX);
+
+  return true;
+}
+
+void BinaryFeatureVector::unpackValues(double* values) const {
+  if (values == NULL)
+    return;
+
+  int x;
+  BinaryWord word;
+
+  for (x = 0; x < size; x++)
+    values[x] = WMTK_FV_MIN;
+
+  for (x = 0; x < word_count; x++)
+    for (word = words[x]; word != 0; word &= word - 1)
+      values[(x * WMTK_BFV_WORD_BITS) + lowestBit(word)] = WMTK_FV_MAX;
+}
+
+bool BinaryFeatureVector::makeORCode(const BinaryFeatureVector& vector, const OR_CODE type) {
+  if (vector.size != size || size == 0 || type == NO_OR)
+    return false;
+
+  for (int x = 0; x < word_count; x++)
+    words[x] |= vector.words[x];
+
+  return true;
+}
+
+bool BinaryFeatureVector::makeANDCode(const BinaryFeatureVector& vector) {
+  if (vector.size != size || size == 0)
+    return false;
+
+  for (int x = 0; x < word_count; x++)
+    words[x] &= vector.words[x];
+
+  return true;
+}
+
+bool BinaryFeatureVector::makeConjunction(const BinaryFeatureVector& first, const BinaryFeatureVector& second) {
+  if (first.size == 0 || second.size == 0 ||
+      first.size > size / second.size || this == &first || this == &second)
+    return false;
+
+  int x, y, offset, shift, target;
+  BinaryWord word;
+
+  clearVector();
+
+  // Copy second into the block of each set feature of first, shifted
+  // to the block's bit position. The bits of second past its last
+  // feature are clear, so nothing spills past the block.
+  for (x = 0; x < first.word_count; x++)
+    for (word = first.words[x]; word != 0; word &= word - 1) {
+      offset = ((x * WMTK_BFV_WORD_BITS) + lowestBit(word)) * second.size;
+      target = offset / WMTK_BFV_WORD_BITS;
+      shift = offset % WMTK_BFV_WORD_BITS;
+      if (shift == 0)
+	for (y = 0; y < second.word_count; y++)
+	  words[target + y] |= second.words[y];
+      else
+	for (y = 0; y < second.word_count; y++) {
+	  words[target + y] |= second.words[y] << shift;
+	  if (target + y + 1 < word_count)
+	    words[target + y + 1] |=
+	      second.words[y] >> (WMTK_BFV_WORD_BITS - shift);
+	}
+    }
+
+  return true;
+}
+
+int BinaryFeatureVector::countFeatures() const {
+  int count = 0;
+  for (int x = 0; x < word_count; x++)
+    count += bitCount(words[x]);
+  return count;
+}
+
+double BinaryFeatureVector::sumWeights(const double* weights) const {
+  if (weights == NULL)
+    return 0.0;
+
+  double value = 0.0;
+  BinaryWord word;
+
+  for (int x = 0; x < word_count; x++)
+    for (word = words[x]; word != 0; word &= word - 1)
+      value += weights[(x * WMTK_BFV_WORD_BITS) + lowestBit(word)];
+
+  return value;
+}
@@ -0,0 +1,147 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+/******************************************************************************
+ * BinaryFeatureVector.h
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * Vector of binary features (each at WMTK_FV_MIN or WMTK_FV_MAX) packed
+ * 64 to a word. Products of binary features are logical ANDs and their
+ * "OR" codes are logical ORs, so conjunctions and "OR" codes of these
+ * vectors are computed a word at a time, and the dot product of a
+ * weight vector with one is the sum of the weights of its set bits.
+ *
+ *****************************************************************************/
+
+#ifndef WMTK_BINARY_FEATURE_VECTOR_H
+#define WMTK_BINARY_FEATURE_VECTOR_H
+
+#include <FeatureVector.h>
+
+// Word of packed features.
+typedef unsigned long long BinaryWord;
+
+// Number of features packed in a word.
+#define WMTK_BFV_WORD_BITS 64
+
+class BinaryFeatureVector {
+
+ public:
+
+  // Default Constructor
+  // Creates an empty vector.
+  BinaryFeatureVector();
+
+  // Constructor
+  // Creates a binary vector of the specified size with every feature
+  // off.
+  BinaryFeatureVector(int vector_size);
+
+  // Copy-Constructor
+  BinaryFeatureVector(const BinaryFeatureVector&);
+
+  // Assignment Operator
+  BinaryFeatureVector& operator=(const BinaryFeatureVector&);
+
+  // Exchanges the contents of this vector with those of the provided
+  // one, without copying or allocating.
+  void swap(BinaryFeatureVector&);
+
+#if __cplusplus >= 201103L
+  // Move-Constructor and Move-Assignment
+  // Take over the contents of the source, which is left valid but
+  // unspecified.
+  BinaryFeatureVector(BinaryFeatureVector&&) noexcept;
+  BinaryFeatureVector& operator=(BinaryFeatureVector&&) noexcept;
+#endif
+
+  // Destructor
+  ~BinaryFeatureVector();
+
+  int getSize() const; // Returns the number of features.
+
+  int getWordCount() const; // Returns the number of words of features.
+
+  // Returns the packed features (read-only); feature x is bit
+  // x % WMTK_BFV_WORD_BITS of word x / WMTK_BFV_WORD_BITS, and the bits
+  // past the last feature are always clear.
+  const BinaryWord* getWords() const;
+
+  // Returns the feature in the specified position (indexed by zero) as
+  // WMTK_FV_MIN or WMTK_FV_MAX.
+  double getValue(int position) const;
+
+  // Sets the feature at the specified position (indexed by zero). Only
+  // WMTK_FV_MIN and WMTK_FV_MAX are accepted.
+  bool setValue(int position, double value);
+
+  // Turns every feature off.
+  void clearVector();
+
+  // Packs the provided feature vector, which must be of the same size.
+  // Returns false (leaving this vector unspecified) if any of its
+  // elements is neither WMTK_FV_MIN nor WMTK_FV_MAX.
+  bool packVector(const FeatureVector& vector);
+
+  // Writes the features into the provided feature vector, which must be
+  // of the same size.
+  bool unpackVector(FeatureVector& vector) const;
+
+  // The same for arrays of getSize() values.
+  bool packValues(const double* values);
+  void unpackValues(double* values) const;
+
+  // Generates the "OR" of this vector and the provided vector and
+  // stores the result in this vector. For binary features both MAX_OR
+  // and NOISY_OR are the logical OR.
+  bool makeORCode(const BinaryFeatureVector& vector, const OR_CODE type);
+
+  // Generates the logical AND (the product) of this vector and the
+  // provided vector and stores the result in this vector.
+  bool makeANDCode(const BinaryFeatureVector& vector);
+
+  // Stores the products of every feature of first with every feature of
+  // second in this vector, which must be as large as the two sizes
+  // multiplied. The features of second vary fastest. Each set feature
+  // of first places a copy of second, a word at a time.
+  bool makeConjunction(const BinaryFeatureVector& first,
+		       const BinaryFeatureVector& second);
+
+  // Returns the number of set features.
+  int countFeatures() const;
+
+  // Returns the dot product of the provided weights (one per feature)
+  // with the vector, which is the sum of the weights of the set
+  // features, visited in increasing order.
+  double sumWeights(const double* weights) const;
+
+ private:
+  BinaryWord* words; // Packed features.
+  int size; // Number of features.
+  int word_count; // Number of words.
+
+  void init();
+  void dispose();
+  void copy(const BinaryFeatureVector&);
+};
+
+#endif
@@ -0,0 +1,193 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+/******************************************************************************
+ * CandidateScorer.cpp
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * This class is a linear model that scores candidate chunks on their own,
+ * to shortlist them before the working memory's search.
+ *
+ *****************************************************************************/
+
+#include <CandidateScorer.h>
+#include <FeatureVector.h>
+#include <cstddef>
+#include <fstream>
+
+void CandidateScorer::init() {
+  s_size = 0;
+  c_size = 0;
+  learning_rate = WMTK_CS_LEARNING_RATE;
+  weights = NULL;
+}
+
+void CandidateScorer::dispose() {
+  storage.release();
+  init();
+}
+
+void CandidateScorer::copy(const CandidateScorer& src) {
+  s_size = src.s_size;
+  c_size = src.c_size;
+  learning_rate = src.learning_rate;
+  storage = src.storage;
+  if (c_size > 0)
+    weights = storage.at(0);
+}
+
+CandidateScorer::CandidateScorer() {
+  init();
+}
+
+CandidateScorer::CandidateScorer(int state_size, int chunk_size, double learning_rate_value) {
+  init();
+
+  if (state_size < 0 || chunk_size < 1)
+    return;
+
+  s_size = state_size;
+  c_size = chunk_size;
+  setLearningRate(learning_rate_value);
+
+  // Allocated zeroed.
+  storage.allocate((s_size + 1) * c_size);
+  weights = storage.at(0);
+}
+
+CandidateScorer::CandidateScorer(const CandidateScorer& L) {
+  init();
+  copy(L);
+}
+
+CandidateScorer::~CandidateScorer() {
+  dispose();
+}
+
+CandidateScorer& CandidateScorer::operator=(const CandidateScorer& Rhs) {
+  if (this != &Rhs) {
+    dispose();
+    copy(Rhs);
+  }
+  return *this;
+}
+
+double CandidateScorer::score(const FeatureVector& state, const FeatureVector& chunk) const {
+  if (weights == NULL || state.getSize() != s_size ||
+      chunk.getSize() != c_size)
+    return 0.0;
+
+  const double* s = state.getValues();
+  const double* c = chunk.getValues();
+  const double* row = weights + c_size;
+  double result = 0.0;
+  double net;
+  int x, y;
+
+  // Each chunk feature is weighted by the constant row plus the rows of
+  // the state features.
+  for (x = 0; x < c_size; x++) {
+    if (c[x] == 0.0)
+      continue;
+    net = weights[x];
+    for (y = 0; y < s_size; y++)
+      if (s[y] != 0.0)
+	net += s[y] * row[(y * c_size) + x];
+    result += c[x] * net;
+  }
+
+  return result;
+}
+
+bool CandidateScorer::buildCue(const FeatureVector& state, double* cue) const {
+  if (weights == NULL || cue == NULL || state.getSize() != s_size)
+    return false;
+
+  const double* s = state.getValues();
+  const double* row = weights + c_size;
+  int x, y;
+
+  for (x = 0; x < c_size; x++)
+    cue[x] = weights[x];
+  for (y = 0; y < s_size; y++)
+    if (s[y] != 0.0)
+      for (x = 0; x < c_size; x++)
+	cue[x] += s[y] * row[(y * c_size) + x];
+
+  return true;
+}
+
+bool CandidateScorer::learn(const FeatureVector& state, const FeatureVector& chunk, double target) {
+  if (weights == NULL || state.getSize() != s_size ||
+      chunk.getSize() != c_size)
+    return false;
+
+  const double* s = state.getValues();
+  const double* c = chunk.getValues();
+  double* row = weights + c_size;
+  double step = learning_rate * (target - score(state, chunk));
+  int x, y;
+
+  for (x = 0; x < c_size; x++) {
+    if (c[x] == 0.0)
+      continue;
+    weights[x] += step * c[x];
+    for (y = 0; y < s_size; y++)
+      if (s[y] != 0.0)
+	row[(y * c_size) + x] += step * s[y] * c[x];
+  }
+
+  return true;
+}
+
+double CandidateScorer::getLearningRate() const {
+  return learning_rate;
+}
+
+bool CandidateScorer::setLearningRate(double value) {
+  if (value < 0.0)
+    return false;
+
+  learning_rate = value;
+  return true;
+}
+
+bool CandidateScorer::writeWeights(ofstream& file_stream) {
+  if (weights == NULL)
+    return false;
+
+  for (int x = 0; x < (s_size + 1) * c_size; x++)
+    file_stream << weights[x] << " " << endl;
+
+  return true;
+}
+
+bool CandidateScorer::readWeights(ifstream& file_stream) {
+  if (weights == NULL)
+    return false;
+
+  for (int x = 0; x < (s_size + 1) * c_size; x++)
+    file_stream >> weights[x];
+
+  return true;
+}
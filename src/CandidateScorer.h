@@ -0,0 +1,118 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+/******************************************************************************
+ * CandidateScorer.h
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * This class is the first stage of the working memory's search when there
+ * are many candidate chunks: a linear model that scores each candidate on
+ * its own, so that only the best-scoring ones go on to the search over
+ * assignments of candidates to slots. Its input vector is the conjunction
+ * of (1, state features) with the candidate's chunk features, so the
+ * scores can depend on the state as well as on the chunk.
+ *
+ * The model is trained by least mean squares toward a target given for
+ * each candidate; the WorkingMemory class uses the critic's marginal value
+ * of including the chunk in the contents (see WorkingMemory::setShortlist).
+ *
+ * The weights sit in a single NumericArena, one row of chunk weights for
+ * the constant and then for each state feature.
+ *
+ *****************************************************************************/
+
+#ifndef WMTK_CANDIDATE_SCORER_H
+#define WMTK_CANDIDATE_SCORER_H
+
+#define WMTK_CS_LEARNING_RATE 0.01
+
+#include <numeric_arena.h>
+#include <fstream>
+
+using namespace std;
+
+class FeatureVector;
+
+class CandidateScorer {
+
+ public:
+
+  // Constructor
+  CandidateScorer();
+
+  // Constructor
+  // Creates a scorer for chunk vectors of size chunk_size given state
+  // vectors of size state_size.
+  CandidateScorer(int state_size,
+		  int chunk_size,
+		  double learning_rate_value = WMTK_CS_LEARNING_RATE);
+
+  // Copy-Constructor
+  CandidateScorer(const CandidateScorer&);
+
+  // Destructor
+  ~CandidateScorer();
+
+  // Assignment Operator
+  CandidateScorer& operator=(const CandidateScorer&);
+
+  // Returns the score of the chunk vector given the state vector (zero
+  // if either has the wrong size).
+  double score(const FeatureVector& state, const FeatureVector& chunk) const;
+
+  // Writes the weights that score() applies to each chunk feature given
+  // the state vector to cue (c_size elements), so that the score of any
+  // chunk vector is its dot product with the cue. Returns false if the
+  // state vector has the wrong size.
+  bool buildCue(const FeatureVector& state, double* cue) const;
+
+  // Moves the score of the chunk vector given the state vector toward
+  // the target by one least mean squares step. Returns false if either
+  // vector has the wrong size.
+  bool learn(const FeatureVector& state, const FeatureVector& chunk,
+	     double target);
+
+  // Returns the learning rate.
+  double getLearningRate() const;
+
+  // Sets the learning rate. Returns false on failure, true otherwise.
+  bool setLearningRate(double value);
+
+  // Writes/reads the weights, one per line. Only return false if the
+  // scorer is not initialized.
+  bool writeWeights(ofstream& file_stream);
+  bool readWeights(ifstream& file_stream);
+
+ private:
+  int s_size; // Size of the state vectors.
+  int c_size; // Size of the chunk vectors.
+  double learning_rate; // Learning rate.
+  NumericArena storage; // Weights.
+  double* weights; // (s_size + 1) rows of c_size weights (in storage).
+
+  void init();
+  void dispose();
+  void copy(const CandidateScorer&);
+};
+
+#endif
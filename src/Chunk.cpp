@@ -45,6 +45,7 @@
 
 #include <Chunk.h>
 #include <cstddef>
+#include <algorithm>
 
 Chunk::Chunk() {
   chunk_data = NULL;
@@ -73,6 +74,24 @@ Chunk& Chunk::operator=(const Chunk& Rhs) {
   return *this;
 }
 
+void Chunk::swap(Chunk& other) {
+  std::swap(chunk_data, other.chunk_data);
+  chunk_info.swap(other.chunk_info);
+}
+
+#if __cplusplus >= 201103L
+Chunk::Chunk(Chunk&& L) noexcept {
+  chunk_data = NULL;
+  chunk_info = "NULL";
+  swap(L);
+}
+
+Chunk& Chunk::operator=(Chunk&& Rhs) noexcept {
+  swap(Rhs);
+  return *this;
+}
+#endif
+
 void* Chunk::getData() const {
   return chunk_data;
 }
@@ -71,6 +71,18 @@ class Chunk {
   // Assignment Operator
   Chunk& operator=(const Chunk&);
 
+  // Exchanges the contents of this chunk with those of the provided
+  // one, without copying or allocating.
+  void swap(Chunk&);
+
+#if __cplusplus >= 201103L
+  // Move-Constructor and Move-Assignment
+  // Take over the contents of the source, which is left valid but
+  // unspecified.
+  Chunk(Chunk&&) noexcept;
+  Chunk& operator=(Chunk&&) noexcept;
+#endif
+
   // Returns a pointer to the chunk data.
   void* getData() const;
 
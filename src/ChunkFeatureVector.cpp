@@ -40,6 +40,7 @@
  *****************************************************************************/
 
 #include <ChunkFeatureVector.h>
+#include <algorithm>
 
 ChunkFeatureVector::ChunkFeatureVector() : FeatureVector() {
   translate = NULL; // Empty function
@@ -57,7 +58,6 @@ ChunkFeatureVector::ChunkFeatureVector(int vector_size, void (*translation_funct
 
 ChunkFeatureVector::ChunkFeatureVector(const ChunkFeatureVector& L) : FeatureVector(L) {
   translate = NULL;
-  FeatureVector::operator=(L); // Use parent assignment
 
   if (L.translate != NULL) // If it has a function, use it
     translate = L.translate;
@@ -77,6 +77,23 @@ ChunkFeatureVector& ChunkFeatureVector::operator=(const ChunkFeatureVector& Rhs)
   return *this;
 }
 
+void ChunkFeatureVector::swap(ChunkFeatureVector& other) {
+  FeatureVector::swap(other);
+  std::swap(translate, other.translate);
+}
+
+#if __cplusplus >= 201103L
+ChunkFeatureVector::ChunkFeatureVector(ChunkFeatureVector&& L) noexcept : FeatureVector() {
+  translate = NULL;
+  swap(L);
+}
+
+ChunkFeatureVector& ChunkFeatureVector::operator=(ChunkFeatureVector&& Rhs) noexcept {
+  swap(Rhs);
+  return *this;
+}
+#endif
+
 ChunkFeatureVector::~ChunkFeatureVector() {
   translate = NULL; // This may not be needed, but you never know...
 }
@@ -86,6 +103,7 @@ bool ChunkFeatureVector::updateFeatures(Chunk& chunk, WorkingMemory& wm) {
     return false;	// If we don't have a function, this is a problem
 
   translate(*this, chunk, wm);
+  clampValues();	// In case of bulk writes (see getWritableValues)
   return true;
 }
 
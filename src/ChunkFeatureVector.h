@@ -66,13 +66,26 @@ class ChunkFeatureVector : public FeatureVector {
 
   // Assignment Operator
   ChunkFeatureVector& operator=(const ChunkFeatureVector&);
+
+  // Exchanges the contents of this vector with those of the provided
+  // one, without copying or allocating.
+  void swap(ChunkFeatureVector&);
+
+#if __cplusplus >= 201103L
+  // Move-Constructor and Move-Assignment
+  // Take over the contents of the source, which is left valid but
+  // unspecified.
+  ChunkFeatureVector(ChunkFeatureVector&&) noexcept;
+  ChunkFeatureVector& operator=(ChunkFeatureVector&&) noexcept;
+#endif
 		
   // Destructor
   ~ChunkFeatureVector();
 
   // Calls the translation function to map the information about the
-  // current state into the vector. Returns true if successful, and
-  // false otherwise.
+  // current state into the vector, then limits the elements to the
+  // valid range (the function may fill getWritableValues() directly).
+  // Returns true if successful, and false otherwise.
   bool	updateFeatures(Chunk& chunk, WorkingMemory& wm);
 
   // Sets the translation function to the one provided as an argument.
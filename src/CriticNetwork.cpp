@@ -43,7 +43,9 @@
 #include <CriticNetwork.h>
 #include <cstddef>
 #include <fstream>
+#include <algorithm>
 #include <FeatureVector.h>
+#include <AggregateFeatureVector.h>
 
 // Neural Network Tools
 #include <neural_unit.h>
@@ -52,45 +54,46 @@
 #include <td_full_forward_projection.h>
 #include <simple_linear_activation_function.h>
 #include <random_number_generator.h>
+#include <LinearTDCritic.h>
+#include <LowRankTDCritic.h>
+#include <HiddenTDCritic.h>
+#include <TiedTDCritic.h>
 
+// Activation of the bias unit, used when folding the bias weight change
+// into the critic's value.
+static double bias_layer_acts[1] = { 1.0 };
 
-CriticNetwork::CriticNetwork() {
+// Last revision of the weights handed out to any critic.
+static unsigned long last_weights_revision = 0;
+
+
+void CriticNetwork::init() {
+  engine = LINEAR_ENGINE;
+  input_size = 0;
+  td_critic = NULL;
   input_layer = NULL;
   critic_layer = NULL;
   bias_layer = NULL;
   input_to_critic_projection = NULL;
   bias_critic_projection = NULL;
   slaf = NULL;
+  step_inputs = NULL;
+  step_nonzero = NULL;
+  step_nonzero_count = -1;
+  step_net = 0.0;
+  step_value = 0.0;
+  step_current = false;
+  reviseWeights();
 }
 
-CriticNetwork::CriticNetwork(int input_layer_size) {
-  if (input_layer_size < 1) {
-    input_layer = NULL;
-    critic_layer = NULL;
-    bias_layer = NULL;
-    input_to_critic_projection = NULL;
-    bias_critic_projection = NULL;
-    slaf = NULL;
-    return;
-  }
-
-  slaf = new SimpleLinearActivationFunction();
-  bias_layer = new Layer(1, slaf);
-  bias_layer->getUnit(0)->setAct(1.0);
-
-  input_layer = new Layer(input_layer_size, slaf);
-  critic_layer = new TDLayer(1, slaf, WMTK_CN_GAMMA);
-
-  input_to_critic_projection = new TDFullForwardProjection(input_layer,
-							   critic_layer, 0, WMTK_CN_LAMBDA, critic_layer);
-  input_to_critic_projection->setLearningRate(WMTK_CN_LEARNING_RATE);
-  bias_critic_projection = new TDFullForwardProjection(bias_layer,
-						       critic_layer, 0, WMTK_CN_LAMBDA, critic_layer);
-  bias_critic_projection->setLearningRate(WMTK_CN_LEARNING_RATE);
-
+void CriticNetwork::reviseWeights() {
+  weights_revision = ++last_weights_revision;
 }
 
-CriticNetwork::~CriticNetwork() {
+void CriticNetwork::dispose() {
+  if (td_critic != NULL)
+    delete td_critic;
+
   if (input_layer != NULL) {
     delete input_to_critic_projection;
     delete bias_critic_projection;
@@ -99,200 +102,643 @@ CriticNetwork::~CriticNetwork() {
     delete bias_layer;
     delete slaf;
   }
+
+  if (step_inputs != NULL)
+    delete [] step_inputs;
+  if (step_nonzero != NULL)
+    delete [] step_nonzero;
+
+  init();
 }
 
-CriticNetwork::CriticNetwork(const CriticNetwork& L) {
-  int x,y;
-  input_layer = NULL;
-  critic_layer = NULL;
-  bias_layer = NULL;
-  input_to_critic_projection = NULL;
-  bias_critic_projection = NULL;
-  slaf = NULL;
+void CriticNetwork::buildNetwork(int size, double gamma, double lambda, double learning_rate) {
+  input_size = size;
 
-  if (L.input_layer != NULL) {
+  if (engine == LINEAR_ENGINE) {
+    td_critic = new LinearTDCritic(size, gamma, lambda, learning_rate);
+  }
+  else {
     slaf = new SimpleLinearActivationFunction();
     bias_layer = new Layer(1, slaf);
     bias_layer->getUnit(0)->setAct(1.0);
-    input_layer = new Layer(L.input_layer->Size(), slaf);
-    critic_layer = new TDLayer(1, slaf, L.critic_layer->getDiscountRate());
+
+    input_layer = new Layer(size, slaf);
+    critic_layer = new TDLayer(1, slaf, gamma);
 
     input_to_critic_projection = new TDFullForwardProjection(input_layer,
-							     critic_layer, 0, L.input_to_critic_projection->getLambda(),
-							     critic_layer);
-    input_to_critic_projection->setLearningRate(
-						L.input_to_critic_projection->getLearningRate());
+							     critic_layer, 0, lambda, critic_layer);
+    input_to_critic_projection->setLearningRate(learning_rate);
     bias_critic_projection = new TDFullForwardProjection(bias_layer,
-							 critic_layer, 0, L.bias_critic_projection->getLambda(),
-							 critic_layer);
+							 critic_layer, 0, lambda, critic_layer);
+    bias_critic_projection->setLearningRate(learning_rate);
+  }
+
+  allocateTimeStep();
+}
+
+void CriticNetwork::allocateTimeStep() {
+  step_inputs = new double[input_size];
+  for (int x = 0; x < input_size; x++)
+    step_inputs[x] = 0.0;
+  step_nonzero = new int[input_size];
+  step_nonzero_count = 0;
+  step_net = 0.0;
+  step_value = 0.0;
+  step_current = false;
+}
+
+void CriticNetwork::copy(const CriticNetwork& src) {
+  int x;
+
+  engine = src.engine;
+  if (src.input_size == 0)
+    return;
+
+  if (src.td_critic != NULL) {
+    input_size = src.input_size;
+    td_critic = src.td_critic->clone();
+    step_inputs = new double[input_size];
+    step_nonzero = new int[input_size];
+  }
+  else {
+    buildNetwork(src.input_size, src.critic_layer->getDiscountRate(),
+		 src.input_to_critic_projection->getLambda(),
+		 src.input_to_critic_projection->getLearningRate());
+    bias_critic_projection->setLambda(src.bias_critic_projection->getLambda());
     bias_critic_projection->setLearningRate(
-					    L.bias_critic_projection->getLearningRate());
+					    src.bias_critic_projection->getLearningRate());
+
+    input_to_critic_projection->copyWeights(src.input_to_critic_projection);
+    bias_critic_projection->copyWeights(src.bias_critic_projection);
+  }
+
+  for (x = 0; x < input_size; x++)
+    step_inputs[x] = src.step_inputs[x];
+  for (x = 0; x < src.step_nonzero_count; x++)
+    step_nonzero[x] = src.step_nonzero[x];
+  step_nonzero_count = src.step_nonzero_count;
+  step_net = src.step_net;
+  step_value = src.step_value;
+  step_current = src.step_current;
+}
+
+CriticNetwork::CriticNetwork() {
+  init();
+}
+
+CriticNetwork::CriticNetwork(int input_layer_size, CRITIC_ENGINE engine_type) {
+  init();
+
+  // The other engines have constructors of their own.
+  if (input_layer_size < 1 ||
+      (engine_type != NNET_ENGINE && engine_type != LINEAR_ENGINE))
+    return;
+
+  engine = engine_type;
+
+  buildNetwork(input_layer_size, WMTK_CN_GAMMA, WMTK_CN_LAMBDA,
+	       WMTK_CN_LEARNING_RATE);
+}
 
-    for (x = 0; x < input_layer->Size(); x++)
-      for (y = 0; y < critic_layer->Size(); y++)
-	input_to_critic_projection->setWeight(x,y,
-					      L.input_to_critic_projection->getWeight(x,y));
+CriticNetwork::CriticNetwork(int state_size, int chunk_size, int number_of_chunks, int rank, bool conjunct_state) {
+  init();
+  engine = LOW_RANK_ENGINE;
+
+  LowRankTDCritic* critic = new LowRankTDCritic(state_size, chunk_size,
+						number_of_chunks, chunk_size,
+						rank, conjunct_state,
+						WMTK_CN_GAMMA, WMTK_CN_LAMBDA,
+						WMTK_CN_LEARNING_RATE);
+  if (critic->getInputSize() < 1) {
+    delete critic;
+    return;
+  }
+
+  td_critic = critic;
+  input_size = critic->getInputSize();
+  allocateTimeStep();
+}
+
+CriticNetwork::CriticNetwork(int input_layer_size, int number_of_hidden_layers, const int* hidden_layer_sizes, HIDDEN_ACTIVATION activation) {
+  init();
+  engine = HIDDEN_ENGINE;
+
+  HiddenTDCritic* critic = new HiddenTDCritic(input_layer_size,
+					      number_of_hidden_layers,
+					      hidden_layer_sizes, activation,
+					      WMTK_CN_GAMMA, WMTK_CN_LAMBDA,
+					      WMTK_CN_HIDDEN_LEARNING_RATE);
+  if (critic->getInputSize() < 1) {
+    delete critic;
+    return;
+  }
 
-    for (y = 0; y < critic_layer->Size(); y++)
-      bias_critic_projection->setWeight(0,y,
-					L.bias_critic_projection->getWeight(0,y));
+  td_critic = critic;
+  input_size = critic->getInputSize();
+  allocateTimeStep();
+}
 
+CriticNetwork::CriticNetwork(int state_size, int chunk_size, int number_of_chunks, bool use_pairs) {
+  init();
+  engine = TIED_ENGINE;
+
+  TiedTDCritic* critic = new TiedTDCritic(state_size, chunk_size,
+					  number_of_chunks, chunk_size,
+					  use_pairs, WMTK_CN_GAMMA,
+					  WMTK_CN_LAMBDA,
+					  WMTK_CN_LEARNING_RATE);
+  if (critic->getInputSize() < 1) {
+    delete critic;
+    return;
   }
 
+  td_critic = critic;
+  input_size = critic->getInputSize();
+  allocateTimeStep();
+}
+
+CriticNetwork::~CriticNetwork() {
+  dispose();
+}
+
+CriticNetwork::CriticNetwork(const CriticNetwork& L) {
+  init();
+  copy(L);
 }
 
 CriticNetwork& CriticNetwork::operator=(const CriticNetwork& Rhs) {
-  int x,y;
   if (this != &Rhs) {
-    if (input_layer != NULL) {
-      delete input_to_critic_projection;
-      delete bias_critic_projection;
-      delete input_layer;
-      delete critic_layer;
-      delete bias_layer;
-      delete slaf;
-    }
-
-    if (Rhs.input_layer != NULL) {
-      slaf = new SimpleLinearActivationFunction();
-      bias_layer = new Layer(1, slaf);
-      bias_layer->getUnit(0)->setAct(1.0);
-      input_layer = new Layer(Rhs.input_layer->Size(), slaf);
-      critic_layer = new TDLayer(1, slaf,
-				 Rhs.critic_layer->getDiscountRate());
-
-      input_to_critic_projection = new TDFullForwardProjection(
-							       input_layer, critic_layer, 0,
-							       Rhs.input_to_critic_projection->getLambda(), critic_layer);
-      input_to_critic_projection->setLearningRate(
-						  Rhs.input_to_critic_projection->getLearningRate());
-      bias_critic_projection = new TDFullForwardProjection(bias_layer,
-							   critic_layer, 0, Rhs.bias_critic_projection->getLambda(),
-							   critic_layer);
-      bias_critic_projection->setLearningRate(
-					      Rhs.bias_critic_projection->getLearningRate());
-
-      for (x = 0; x < input_layer->Size(); x++)
-	for (y = 0; y < critic_layer->Size(); y++)
-	  input_to_critic_projection->setWeight(x,y,
-						Rhs.input_to_critic_projection->getWeight(x,y));
-
-      for (y = 0; y < critic_layer->Size(); y++)
-	bias_critic_projection->setWeight(0,y,
-					  Rhs.bias_critic_projection->getWeight(0,y));
-    }
+    dispose();
+    copy(Rhs);
   }
   return *this;
 }
 
+void CriticNetwork::swap(CriticNetwork& other) {
+  // The layers and projections refer to each other by address, so they
+  // change hands by pointer rather than being moved themselves.
+  std::swap(engine, other.engine);
+  std::swap(input_size, other.input_size);
+  std::swap(td_critic, other.td_critic);
+  std::swap(input_layer, other.input_layer);
+  std::swap(critic_layer, other.critic_layer);
+  std::swap(bias_layer, other.bias_layer);
+  std::swap(input_to_critic_projection, other.input_to_critic_projection);
+  std::swap(bias_critic_projection, other.bias_critic_projection);
+  std::swap(slaf, other.slaf);
+  std::swap(step_inputs, other.step_inputs);
+  std::swap(step_nonzero, other.step_nonzero);
+  std::swap(step_nonzero_count, other.step_nonzero_count);
+  std::swap(step_net, other.step_net);
+  std::swap(step_value, other.step_value);
+  std::swap(step_current, other.step_current);
+  std::swap(weights_revision, other.weights_revision);
+}
+
+#if __cplusplus >= 201103L
+CriticNetwork::CriticNetwork(CriticNetwork&& L) noexcept {
+  init();
+  swap(L);
+}
+
+CriticNetwork& CriticNetwork::operator=(CriticNetwork&& Rhs) noexcept {
+  swap(Rhs);
+  return *this;
+}
+#endif
+
 TDLayer* CriticNetwork::getCriticLayer() const {
   return critic_layer;
 }
 
+CRITIC_ENGINE CriticNetwork::getEngine() const {
+  return engine;
+}
+
+int CriticNetwork::getInputSize() const {
+  return input_size;
+}
+
 bool CriticNetwork::clearEligibilityTraces() {
-  if (input_layer == NULL)
+  if (input_size == 0)
     return false;
 
+  if (td_critic != NULL)
+    return td_critic->clearEligibilityTraces();
+
   return input_to_critic_projection->clearEligibilityTraces() &&
     bias_critic_projection->clearEligibilityTraces();
 }
 
 bool CriticNetwork::initializeWeights(RandomNumberGenerator& rng) {
-  if (input_layer == NULL)
+  if (input_size == 0)
     return false;
 
+  step_current = false;
+  reviseWeights();
+
+  if (td_critic != NULL)
+    return td_critic->initializeWeights(rng);
+
   return input_to_critic_projection->initializeWeights(&rng) && 
     bias_critic_projection->initializeWeights(&rng);
 	
 }
 
-double CriticNetwork::processVector(FeatureVector& features) {
-  if (&features == NULL || input_layer == NULL || features.getSize() != input_layer->Size())
-    return 0.0;
-
-  int x;
-
-  for (x = 0; x < features.getSize(); x++) {
-    input_layer->getUnit(x)->setAct(features.getValue(x));
+double CriticNetwork::computeValue(const double* inputs, const int* nonzero, int count, double& net) {
+  if (td_critic != NULL) {
+    if (nonzero != NULL)
+      net = td_critic->evaluateSparse(inputs, nonzero, count);
+    else
+      net = td_critic->evaluate(inputs);
+    return net;
   }
 
+  input_layer->bindActs(inputs);
+
   critic_layer->clearNets();
   input_to_critic_projection->adjustNets();
   bias_critic_projection->adjustNets();
   critic_layer->computeActivations();
 
+  critic_layer->getUnit(0)->getNets(&net);
   return critic_layer->getUnit(0)->getAct();
+}
+
+void CriticNetwork::restoreTimeStep() {
+  if (!step_current) {
+    step_value = computeValue(step_inputs,
+			      step_nonzero_count < 0 ? NULL : step_nonzero,
+			      step_nonzero_count, step_net);
+    step_current = true;
+    return;
+  }
+
+  if (td_critic != NULL)
+    return;
+
+  critic_layer->getUnit(0)->setNets(&step_net);
+  critic_layer->getUnit(0)->setAct(step_value);
+}
+
+double CriticNetwork::evaluateVector(FeatureVector& features) {
+  if (&features == NULL || input_size == 0 || features.getSize() != input_size)
+    return 0.0;
+
+  double net;
+
+  return computeValue(features.getValues(), features.getNonzeroIndices(),
+		      features.getNonzeroCount(), net);
+}
+
+double CriticNetwork::evaluateAggregate(AggregateFeatureVector& features) {
+  if (input_size == 0 || features.getSize() != input_size)
+    return 0.0;
+
+  if (engine != LINEAR_ENGINE) {
+    features.expandFactors();
+    return evaluateVector(features);
+  }
+
+  LinearTDCritic* linear_critic = (LinearTDCritic*) td_critic;
+  return linear_critic->getBias() +
+    features.contractWeights(linear_critic->getWeights(), weights_revision);
+}
+
+bool CriticNetwork::evaluateVectors(int count, FeatureVector* features[], double* values) {
+  if (features == NULL || values == NULL || input_size == 0)
+    return false;
+
+  int y;
+  bool success = true;
+
+  if (td_critic == NULL) {
+    for (y = 0; y < count; y++) {
+      if (features[y] == NULL || features[y]->getSize() != input_size) {
+	values[y] = 0.0;
+	success = false;
+      }
+      else
+	values[y] = evaluateVector(*features[y]);
+    }
+    return success;
+  }
+
+  // Vectors of the wrong size are evaluated as the remembered time step
+  // and zeroed afterwards.
+  const double** inputs = new const double*[count];
+  for (y = 0; y < count; y++) {
+    if (features[y] == NULL || features[y]->getSize() != input_size) {
+      inputs[y] = step_inputs;
+      success = false;
+    }
+    else
+      inputs[y] = features[y]->getValues();
+  }
+
+  td_critic->evaluateBatch(count, inputs, values);
+
+  for (y = 0; y < count; y++)
+    if (features[y] == NULL || features[y]->getSize() != input_size)
+      values[y] = 0.0;
+  delete [] inputs;
+
+  return success;
+}
+
+bool CriticNetwork::scoreChunks(int count, const FeatureVector* const* chunks, double* scores) {
+  if (engine != TIED_ENGINE || td_critic == NULL || count < 0 ||
+      (count > 0 && (chunks == NULL || scores == NULL)))
+    return false;
+
+  TiedTDCritic* tied_critic = (TiedTDCritic*) td_critic;
+  int chunk_size = tied_critic->getChunkSize();
+
+  for (int x = 0; x < count; x++) {
+    if (chunks[x] == NULL || chunks[x]->getSize() != chunk_size)
+      return false;
+    scores[x] = tied_critic->chunkScore(chunks[x]->getValues());
+  }
+
+  return true;
+}
+
+bool CriticNetwork::scoreChunkPairs(int count, const FeatureVector* const* chunks, double* scores) {
+  if (engine != TIED_ENGINE || td_critic == NULL || count < 0 ||
+      (count > 0 && (chunks == NULL || scores == NULL)))
+    return false;
+
+  TiedTDCritic* tied_critic = (TiedTDCritic*) td_critic;
+  int chunk_size = tied_critic->getChunkSize();
+  int x;
+
+  if (count == 0)
+    return true;
+
+  const double** values = new const double*[count];
+  for (x = 0; x < count; x++) {
+    if (chunks[x] == NULL || chunks[x]->getSize() != chunk_size) {
+      delete [] values;
+      return false;
+    }
+    values[x] = chunks[x]->getValues();
+  }
+
+  tied_critic->pairScores(count, values, scores);
+
+  delete [] values;
+  return true;
+}
+
+double CriticNetwork::scoreContext(const FeatureVector& state, const FeatureVector& or_features) {
+  if (engine != TIED_ENGINE || td_critic == NULL)
+    return 0.0;
+
+  TiedTDCritic* tied_critic = (TiedTDCritic*) td_critic;
+
+  if (state.getSize() != tied_critic->getStateSize() ||
+      or_features.getSize() != tied_critic->getChunkSize())
+    return 0.0;
+
+  return tied_critic->contextScore(state.getValues(),
+				   or_features.getValues());
+}
+
+bool CriticNetwork::hasPairScores() const {
+  if (engine != TIED_ENGINE || td_critic == NULL)
+    return false;
+
+  return ((TiedTDCritic*) td_critic)->hasPairs();
+}
+
+bool CriticNetwork::scoreVectorsAt(int position, int count, const FeatureVector* const* vectors, double* scores) {
+  if (engine != LINEAR_ENGINE || td_critic == NULL || position < 0 ||
+      count < 0 || (count > 0 && (vectors == NULL || scores == NULL)))
+    return false;
+
+  const double* weights =
+    ((LinearTDCritic*) td_critic)->getWeights() + position;
+  const double* values;
+  int x, y;
+
+  for (x = 0; x < count; x++) {
+    if (vectors[x] == NULL ||
+	position + vectors[x]->getSize() > input_size)
+      return false;
+    values = vectors[x]->getValues();
+    scores[x] = 0.0;
+    for (y = 0; y < vectors[x]->getSize(); y++)
+      if (values[y] != 0.0)
+	scores[x] += weights[y] * values[y];
+  }
+
+  return true;
+}
+
+double CriticNetwork::processVector(FeatureVector& features) {
+  if (&features == NULL || input_size == 0 || features.getSize() != input_size)
+    return 0.0;
+
+  storeTimeStep(features.getValues(), features.getNonzeroIndices(),
+		features.getNonzeroCount());
+
+  step_value = computeValue(step_inputs,
+			    step_nonzero_count < 0 ? NULL : step_nonzero,
+			    step_nonzero_count, step_net);
+  step_current = true;
+
+  return step_value;
+}
+
+void CriticNetwork::storeTimeStep(const double* inputs, const int* nonzero, int count) {
+  int x;
+
+  if (nonzero != NULL && step_nonzero_count >= 0) {
+    // Both vectors are sparse, so only their nonzero elements change.
+    for (x = 0; x < step_nonzero_count; x++)
+      step_inputs[step_nonzero[x]] = 0.0;
+    for (x = 0; x < count; x++) {
+      step_nonzero[x] = nonzero[x];
+      step_inputs[nonzero[x]] = inputs[nonzero[x]];
+    }
+    step_nonzero_count = count;
+    return;
+  }
+
+  for (x = 0; x < input_size; x++)
+    step_inputs[x] = inputs[x];
+  if (nonzero == NULL) {
+    step_nonzero_count = -1;
+    return;
+  }
+  for (x = 0; x < count; x++)
+    step_nonzero[x] = nonzero[x];
+  step_nonzero_count = count;
+}
+
+double CriticNetwork::advanceTimeStep(const double* next_inputs, const int* next_nonzero, int next_count, bool value_known, double next_value, double reward_for_current_time_step, bool learn) {
+  double reward[1];
+  reward[0] = reward_for_current_time_step;
+  double net_change[1];
+  double next_net;
+
+  if (learn) {
+    restoreTimeStep();
+    if (td_critic == NULL) {
+      // The traces only need the gradient of the last time step, so it
+      // is staged here and folded into the weight update below.
+      critic_layer->computeBpDeltas(0);
+      input_to_critic_projection->stageEligibilityGradient(0, step_inputs);
+      bias_critic_projection->stageEligibilityGradient(0);
+      critic_layer->shiftActivationState();
+    }
+  }
+
+  if (value_known) {
+    // The critic unit is linear with unit slope, so its net input is
+    // its value.
+    next_net = next_value;
+    if (td_critic == NULL) {
+      critic_layer->getUnit(0)->setNets(&next_net);
+      critic_layer->getUnit(0)->setAct(next_value);
+    }
+  }
+  else
+    next_value = computeValue(next_inputs, next_nonzero, next_count,
+			      next_net);
+
+  if (learn) {
+    reviseWeights();
+    if (td_critic != NULL) {
+      next_value = td_critic->tdUpdateSparse(step_inputs,
+					     step_nonzero_count < 0 ?
+					     NULL : step_nonzero,
+					     step_nonzero_count, step_value,
+					     next_inputs, next_value,
+					     reward_for_current_time_step,
+					     false);
+      next_net = next_value;
+    }
+    else {
+      critic_layer->computeTDError(reward);
+      net_change[0] = 0.0;
+      input_to_critic_projection->updateTracesAndWeights(0, next_inputs,
+							 net_change);
+      bias_critic_projection->updateTracesAndWeights(0, bias_layer_acts,
+						     net_change);
+
+      // Value after the update: w'x = wx + (w' - w)x
+      next_net += net_change[0];
+      next_value = slaf->Compute(next_net);
+    }
+  }
 
+  // The next vector becomes the current time step.
+  storeTimeStep(next_inputs, next_nonzero, next_count);
+  step_net = next_net;
+  step_value = next_value;
+  step_current = true;
+
+  return step_value;
 }
 
 double CriticNetwork::processFinalTimeStep(double reward_for_current_time_step) {
+  if (input_size == 0)
+    return 0.0;
+
   double reward[1];
   reward[0] = reward_for_current_time_step;
+  double net_change[1];
+
+  restoreTimeStep();
+  reviseWeights();
+
+  if (td_critic != NULL) {
+    step_value = td_critic->tdUpdateSparse(step_inputs,
+					   step_nonzero_count < 0 ?
+					   NULL : step_nonzero,
+					   step_nonzero_count, step_value,
+					   step_inputs, step_value,
+					   reward_for_current_time_step, true);
+    step_net = step_value;
+    return step_value;
+  }
 
   critic_layer->computeBpDeltas(0);
-  input_to_critic_projection->updateEligibilityTraces(0);
-  bias_critic_projection->updateEligibilityTraces(0);
+  input_to_critic_projection->stageEligibilityGradient(0, step_inputs);
+  bias_critic_projection->stageEligibilityGradient(0);
   critic_layer->shiftActivationState();
 
   critic_layer->computeTDError(reward, true);
-  input_to_critic_projection->computeWeightChanges(0);
-  bias_critic_projection->computeWeightChanges(0);
-  input_to_critic_projection->updateWeights();
-  bias_critic_projection->updateWeights();
+  net_change[0] = 0.0;
+  input_to_critic_projection->updateTracesAndWeights(0, step_inputs,
+						     net_change);
+  bias_critic_projection->updateTracesAndWeights(0, bias_layer_acts,
+						 net_change);
 
-  critic_layer->clearNets();
-  input_to_critic_projection->adjustNets();
-  bias_critic_projection->adjustNets();
-  critic_layer->computeActivations();
+  step_net += net_change[0];
+  step_value = slaf->Compute(step_net);
 
-  return critic_layer->getUnit(0)->getAct();
+  return step_value;
 }
 
 double CriticNetwork::processVectorAsNextTimeStep(FeatureVector& features, double reward_for_current_time_step, bool learn) {
-  if (&features == NULL || input_layer == NULL || features.getSize() != input_layer->Size())
+  if (&features == NULL || input_size == 0 || features.getSize() != input_size)
     return 0.0;
 
-  double reward[1];
-  reward[0] = reward_for_current_time_step;
+  return advanceTimeStep(features.getValues(), features.getNonzeroIndices(),
+			 features.getNonzeroCount(), false, 0.0,
+			 reward_for_current_time_step, learn);
+}
 
-  if (learn) {
-    critic_layer->computeBpDeltas(0);
-    input_to_critic_projection->updateEligibilityTraces(0);
-    bias_critic_projection->updateEligibilityTraces(0);
-    critic_layer->shiftActivationState();
-    
-    processVector(features);
-    
-    critic_layer->computeTDError(reward);
-    input_to_critic_projection->computeWeightChanges(0);
-    bias_critic_projection->computeWeightChanges(0);
-    input_to_critic_projection->updateWeights();
-    bias_critic_projection->updateWeights();
-  }
+double CriticNetwork::processVectorAsNextTimeStep(FeatureVector& features, double value_of_features, double reward_for_current_time_step, bool learn) {
+  if (&features == NULL || input_size == 0 || features.getSize() != input_size)
+    return 0.0;
 
-  return processVector(features);
+  return advanceTimeStep(features.getValues(), features.getNonzeroIndices(),
+			 features.getNonzeroCount(), true, value_of_features,
+			 reward_for_current_time_step, learn);
+}
 
+double CriticNetwork::getTDError() const {
+  if (td_critic != NULL)
+    return td_critic->getTDError();
+  if (critic_layer != NULL)
+    return critic_layer->getTDError(0);
+  return 0.0;
 }
 
 bool CriticNetwork::writeWeights(ofstream& file_stream) {
-  if (input_layer == NULL)
+  if (input_size == 0)
     return false;
 
+  if (td_critic != NULL)
+    return td_critic->writeWeights(file_stream);
+
   return
     input_to_critic_projection->writeWeights(file_stream) &&
     bias_critic_projection->writeWeights(file_stream);
 }
 
 bool CriticNetwork::readWeights(ifstream& file_stream) {
-  if (input_layer == NULL)
+  if (input_size == 0)
     return false;
 
+  step_current = false;
+  reviseWeights();
+
+  if (td_critic != NULL)
+    return td_critic->readWeights(file_stream);
+
   return
     input_to_critic_projection->readWeights(file_stream) &&
     bias_critic_projection->readWeights(file_stream);
 }
 
 bool CriticNetwork::setLearningRate(double value) {
+  if (td_critic != NULL)
+    return td_critic->setLearningRate(value);
+
   if (input_to_critic_projection != NULL && bias_critic_projection != NULL)
     {
       return input_to_critic_projection->setLearningRate(value) &&
@@ -302,6 +748,9 @@ bool CriticNetwork::setLearningRate(double value) {
 }
 
 double CriticNetwork::getLearningRate() const {
+  if (td_critic != NULL)
+    return td_critic->getLearningRate();
+
   if (input_to_critic_projection != NULL) {
     return input_to_critic_projection->getLearningRate();
   }
@@ -309,6 +758,9 @@ double CriticNetwork::getLearningRate() const {
 }
 
 bool CriticNetwork::setGamma(double value) {
+  if (td_critic != NULL)
+    return td_critic->setGamma(value);
+
   if (critic_layer != NULL) {
     return critic_layer->setDiscountRate(value);
   }
@@ -316,6 +768,9 @@ bool CriticNetwork::setGamma(double value) {
 }
 
 double CriticNetwork::getGamma() const {
+  if (td_critic != NULL)
+    return td_critic->getGamma();
+
   if (critic_layer != NULL) {
     return critic_layer->getDiscountRate();
   }
@@ -323,6 +778,9 @@ double CriticNetwork::getGamma() const {
 }
 
 bool CriticNetwork::setLambda(double value) {
+  if (td_critic != NULL)
+    return td_critic->setLambda(value);
+
   if (input_to_critic_projection != NULL && bias_critic_projection != NULL)
     {
       return input_to_critic_projection->setLambda(value) &&
@@ -332,6 +790,9 @@ bool CriticNetwork::setLambda(double value) {
 }
 
 double CriticNetwork::getLambda() const {
+  if (td_critic != NULL)
+    return td_critic->getLambda();
+
   if (input_to_critic_projection != NULL) {
     return input_to_critic_projection->getLambda();
   }
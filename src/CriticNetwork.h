@@ -46,18 +46,62 @@
 #define WMTK_CN_GAMMA 0.99
 #define WMTK_CN_LAMBDA 0.0
 #define WMTK_CN_LEARNING_RATE 0.0001
+#define WMTK_CN_HIDDEN_LEARNING_RATE 0.01
 
 #include <fstream>
 
 using namespace std;
 
+// Enumeration of critic engines.
+// The NNET_ENGINE builds the critic out of the neural network library's
+// layers and projections. The LINEAR_ENGINE computes the same single
+// linear unit directly on contiguous weight and trace vectors, which is
+// much faster. Both engines read and write the same weight file format.
+// The LOW_RANK_ENGINE represents the weights of a conjunctive code as a
+// low-rank tensor and takes the code's factors (the state, chunk and OR
+// vectors, one after the other) as its input vector. The HIDDEN_ENGINE
+// puts layers of nonlinear hidden units in front of the output unit, so
+// it can learn the interactions between the state and the chunks from
+// the CONCAT code. The TIED_ENGINE weights the CONCAT code with one block
+// of chunk weights shared by every slot (and, optionally, one matrix of
+// pair weights shared by every pair of slots), so a chunk is worth the
+// same in any slot.
+enum CRITIC_ENGINE {
+  NNET_ENGINE,
+  LINEAR_ENGINE,
+  LOW_RANK_ENGINE,
+  HIDDEN_ENGINE,
+  TIED_ENGINE
+};
+
+// Enumeration of activation functions for the hidden units of the
+// HIDDEN_ENGINE: the logistic function, the hyperbolic tangent, and the
+// rectified linear function.
+enum HIDDEN_ACTIVATION {
+  SIGMOID_ACTIVATION,
+  TANH_ACTIVATION,
+  RELU_ACTIVATION
+};
+
+// Enumeration of ways for the chunk slots of the CONCAT code to share
+// critic weights: not at all (each slot has its own weights), through
+// one block of chunk weights, or through one block of chunk weights and
+// one matrix of pair weights (see TiedTDCritic).
+enum SLOT_TYING {
+  UNTIED_SLOTS,
+  TIED_SLOTS,
+  TIED_SLOTS_AND_PAIRS
+};
+
 class FeatureVector;
+class AggregateFeatureVector;
 
 class Layer;
 class TDLayer;
 class TDFullForwardProjection;
 class SimpleLinearActivationFunction;
 class RandomNumberGenerator;
+class TDCritic;
 
 class CriticNetwork {
 
@@ -67,8 +111,44 @@ class CriticNetwork {
   CriticNetwork();
 
   // Constructor
-  // Creates a critic network with an input layer of the specified size.
-  CriticNetwork(int input_layer_size);
+  // Creates a critic network with an input layer of the specified size,
+  // computed by the specified engine, which must be NNET_ENGINE or
+  // LINEAR_ENGINE (the network is left empty otherwise).
+  CriticNetwork(int input_layer_size,
+		CRITIC_ENGINE engine_type = LINEAR_ENGINE);
+
+  // Constructor
+  // Creates a LOW_RANK_ENGINE critic for the conjunction of
+  // number_of_chunks chunk vectors of size chunk_size, with a weight
+  // tensor of the given rank. The state vector is part of the
+  // conjunction if conjunct_state is set (COMPLETE_CONJ) and is weighted
+  // linearly otherwise (WM_CONJ). Input vectors hold the state vector,
+  // each chunk vector, and an OR vector of size chunk_size, in that
+  // order.
+  CriticNetwork(int state_size,
+		int chunk_size,
+		int number_of_chunks,
+		int rank,
+		bool conjunct_state);
+
+  // Constructor
+  // Creates a HIDDEN_ENGINE critic for input vectors of the specified
+  // size, with number_of_hidden_layers hidden layers whose sizes are
+  // listed (from the input side) in hidden_layer_sizes.
+  CriticNetwork(int input_layer_size,
+		int number_of_hidden_layers,
+		const int* hidden_layer_sizes,
+		HIDDEN_ACTIVATION activation);
+
+  // Constructor
+  // Creates a TIED_ENGINE critic for the CONCAT code of a state vector of
+  // size state_size and number_of_chunks chunk vectors of size
+  // chunk_size (followed by an OR vector of size chunk_size). The slots
+  // share pair weights as well if use_pairs is set.
+  CriticNetwork(int state_size,
+		int chunk_size,
+		int number_of_chunks,
+		bool use_pairs);
 
   // Copy-Constructor
   CriticNetwork(const CriticNetwork&);
@@ -79,11 +159,30 @@ class CriticNetwork {
   // Assignment Operator
   CriticNetwork& operator=(const CriticNetwork&);
 
+  // Exchanges the contents of this network with those of the provided
+  // one, without copying or allocating.
+  void swap(CriticNetwork&);
+
+#if __cplusplus >= 201103L
+  // Move-Constructor and Move-Assignment
+  // Take over the contents of the source, which is left valid but
+  // unspecified.
+  CriticNetwork(CriticNetwork&&) noexcept;
+  CriticNetwork& operator=(CriticNetwork&&) noexcept;
+#endif
+
   // Returns a pointer to the critic_layer. (This is used for creating
   // the actor network, which needs to have access to the critic_layer
-  // to process the TD error.)
+  // to process the TD error.) Only the NNET_ENGINE has a critic_layer;
+  // NULL is returned for the other engines.
   TDLayer* getCriticLayer() const;
 
+  // Returns the engine used to compute the critic.
+  CRITIC_ENGINE getEngine() const;
+
+  // Returns the size of the input vectors.
+  int getInputSize() const;
+
   // Clears the eligibility traces for the critic network.
   bool clearEligibilityTraces();
 
@@ -92,9 +191,53 @@ class CriticNetwork {
   bool initializeWeights(RandomNumberGenerator& rng);
 
   // Processes the vector representation through the network, then
-  // returns the value of the processed vector.
+  // returns the value of the processed vector. The vector and its value
+  // are remembered as the current time step.
   double processVector(FeatureVector& features);
 
+  // Returns the value of the vector without disturbing the remembered
+  // time step. (Use this when searching over candidate representations.)
+  double evaluateVector(FeatureVector& features);
+
+  // Returns the value of the aggregate vector of the factors last given
+  // to AggregateFeatureVector::setFactors, without disturbing the
+  // remembered time step. The linear engine contracts its weights with
+  // the factors directly; the other engines expand the vector first.
+  double evaluateAggregate(AggregateFeatureVector& features);
+
+  // Computes the values of several vectors at once without disturbing
+  // the remembered time step. Returns false if any vector has the wrong
+  // size.
+  bool evaluateVectors(int count, FeatureVector* features[],
+		       double* values);
+
+  // For the TIED_ENGINE, the value of an input vector is the sum of the
+  // scores of its chunk vectors, the scores of each pair of its chunk
+  // vectors and the score of its state and OR vectors, so the value of
+  // every assignment of candidates to slots can be added up from scores
+  // computed once per candidate. These functions compute the scores of
+  // count chunk vectors, the count by count table of the scores of
+  // their pairs (all zero without pair weights), and the score of a
+  // state and OR vector. They return false (or zero) for the other
+  // engines or on vectors of the wrong size.
+  bool scoreChunks(int count, const FeatureVector* const* chunks,
+		   double* scores);
+  bool scoreChunkPairs(int count, const FeatureVector* const* chunks,
+		       double* scores);
+  double scoreContext(const FeatureVector& state,
+		      const FeatureVector& or_features);
+
+  // Returns true for a TIED_ENGINE critic with pair weights (when the
+  // value is not a sum of terms of one chunk each).
+  bool hasPairScores() const;
+
+  // For the LINEAR_ENGINE, computes the contribution to the value of
+  // each of count vectors placed in the input vector at the given
+  // position (the dot product with the weights there). Returns false for
+  // the other engines or if a vector does not fit.
+  bool scoreVectorsAt(int position, int count,
+		      const FeatureVector* const* vectors, double* scores);
+
   // Processes the given vector through the network as the next state.
   // The last time step's representation is the same as that used in the
   // last processVector or processVectorAsNextTimeStep call. The reward
@@ -104,6 +247,14 @@ class CriticNetwork {
 				     double reward_for_current_time_step,
 				     bool learn = true);
 
+  // Same as above, but the value of the given vector under the current
+  // weights is already known (from evaluateVector), so no forward pass
+  // is needed to compute the TD error.
+  double processVectorAsNextTimeStep(FeatureVector& features,
+				     double value_of_features,
+				     double reward_for_current_time_step,
+				     bool learn);
+
   // Uses the last vector processed via processVectorAsNextTimeStep
   // (preferably) as the final state. This case absorbs the provided
   // reward information. The clearEligibilityTraces method should
@@ -111,6 +262,10 @@ class CriticNetwork {
   // this choice is left to the network user.)
   double processFinalTimeStep(double reward_for_current_time_step);
 
+  // Returns the TD error of the last learning step (zero if the network
+  // has not learned yet). An actor network is trained with it.
+  double getTDError() const;
+
   // Writes the weights of the network out to the provided file stream.
   // The stream should be ready to receive the values for writing. The
   // function only returns false if the network is not yet initialized.
@@ -146,6 +301,11 @@ class CriticNetwork {
   bool setLambda(double value);
 
  private:
+  CRITIC_ENGINE engine; // Engine used to compute the critic.
+  int input_size; // Size of the input vectors (zero if the network
+  // is not initialized).
+  TDCritic* td_critic; // The critic for every engine other than
+  // the NNET_ENGINE.
   Layer* input_layer; // This is a layer of neural units that will be
   // provided with the representation from an
   // AggregateFeatureVector.
@@ -170,6 +330,48 @@ class CriticNetwork {
   SimpleLinearActivationFunction* slaf; // This is the activation
   // function that will be used by the units in the
   // network.
+  double* step_inputs; // Representation of the current time step, as
+  // last given to processVector or
+  // processVectorAsNextTimeStep.
+  int* step_nonzero; // Positions of the nonzero step_inputs, in order,
+  int step_nonzero_count; // and their number (-1 if not known).
+  double step_net; // Net input and value of the critic unit for
+  double step_value; // step_inputs under the current weights.
+  bool step_current; // False if the weights have changed since
+  // step_value was computed.
+  unsigned long weights_revision; // Changes whenever the weights do (see
+  // AggregateFeatureVector::contractWeights).
+
+  // Gives the weights a revision that no weights have had before.
+  void reviseWeights();
+
+  // Forward pass of the given inputs (read in place, not copied);
+  // leaves the critic unit's net input in net. The nonzero inputs may
+  // be listed (nonzero is NULL otherwise) for the critic engines to
+  // gather only those.
+  double computeValue(const double* inputs, const int* nonzero, int count,
+		      double& net);
+
+  // Makes the given inputs the current time step.
+  void storeTimeStep(const double* inputs, const int* nonzero, int count);
+
+  // Puts the critic unit back into the state of the current time step.
+  void restoreTimeStep();
+
+  // Moves the network from the current time step to next_inputs,
+  // learning from the transition if requested.
+  double advanceTimeStep(const double* next_inputs,
+			 const int* next_nonzero, int next_count,
+			 bool value_known, double next_value, double reward,
+			 bool learn);
+
+  // Constructor and Destructor utility functions
+  void init();
+  void dispose();
+  void copy(const CriticNetwork&);
+  void buildNetwork(int size, double gamma, double lambda,
+		    double learning_rate);
+  void allocateTimeStep();
 
 };
 
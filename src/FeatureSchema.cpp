@@ -0,0 +1,156 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+/******************************************************************************
+ * FeatureSchema.cpp
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * Description of how records of real values are coded into feature
+ * vectors, with the thresholds and means of each field precomputed.
+ *
+ *****************************************************************************/
+
+#include <FeatureSchema.h>
+#include <feature_kernels.h>
+#include <cstddef>
+
+FeatureSchema::FeatureSchema() {
+  required_size = 0;
+}
+
+FeatureSchema::FeatureSchema(const FeatureSchema& L) : fields(L.fields), cache(L.cache) {
+  required_size = L.required_size;
+}
+
+FeatureSchema& FeatureSchema::operator=(const FeatureSchema& Rhs) {
+  if (this != &Rhs) {
+    fields = Rhs.fields;
+    cache = Rhs.cache;
+    required_size = Rhs.required_size;
+  }
+  return *this;
+}
+
+FeatureSchema::~FeatureSchema() {
+}
+
+int FeatureSchema::addField(string name, FIELD_CODE code, int start_position, int end_position, double minimum, double maximum, double variance) {
+  if (start_position > end_position || minimum > maximum ||
+      start_position < 0 || (code == GAUSSIAN_CODE && variance <= 0.0) ||
+      getFieldIndex(name) >= 0)
+    return -1;
+
+  int x;
+  Field field;
+  double step;
+
+  field.name = name;
+  field.code = code;
+  field.start = start_position;
+  field.length = (end_position - start_position) + 1;
+  field.maximum = maximum;
+  field.variance = variance;
+  field.cache = cache.size();
+
+  // The thresholds (or means) are computed as by the FeatureVector
+  // coding functions, so that the codes compare the same way.
+  if (code == SPEEDOMETER_CODE)
+    step = (maximum - minimum) /
+      ((double) (end_position - start_position) + 1.0);
+  else
+    step = (maximum - minimum) /
+      ((double) (end_position - start_position));
+  for (x = 0; x < field.length; x++)
+    cache.push_back(minimum + (((double) x) * step));
+
+  // The speedometer code also needs the upper bound of each band (the
+  // last band is closed at maximum and handled separately).
+  if (code == SPEEDOMETER_CODE)
+    for (x = 1; x < field.length; x++)
+      cache.push_back(cache[field.cache + x]);
+
+  fields.push_back(field);
+  if (end_position + 1 > required_size)
+    required_size = end_position + 1;
+
+  return fields.size() - 1;
+}
+
+int FeatureSchema::getNumberOfFields() const {
+  return fields.size();
+}
+
+int FeatureSchema::getFieldIndex(string name) const {
+  for (int x = 0; x < (int) fields.size(); x++)
+    if (fields[x].name == name)
+      return x;
+  return -1;
+}
+
+int FeatureSchema::getRequiredSize() const {
+  return required_size;
+}
+
+void FeatureSchema::encodeValue(double* values, const Field& field, double value) const {
+  const double* thresholds = &cache[field.cache];
+  double* dest = values + field.start;
+  int last = field.length - 1;
+
+  switch (field.code) {
+  case THERMOMETER_CODE:
+    thresholdValues(dest, thresholds, field.length, value,
+		    WMTK_FV_MIN, WMTK_FV_MAX);
+    break;
+  case GAUSSIAN_CODE:
+    gaussianValues(dest, thresholds, field.length, value, field.variance,
+		   WMTK_FV_MAX - WMTK_FV_MIN, WMTK_FV_MIN);
+    break;
+  case SPEEDOMETER_CODE:
+    bandValues(dest, thresholds, thresholds + field.length, last, value,
+	       WMTK_FV_MIN, WMTK_FV_MAX);
+    if (value >= thresholds[last] && value <= field.maximum)
+      dest[last] = WMTK_FV_MAX;
+    else
+      dest[last] = WMTK_FV_MIN;
+    break;
+  }
+}
+
+bool FeatureSchema::encodeField(FeatureVector& vector, int field, double value) const {
+  if (field < 0 || field >= (int) fields.size() ||
+      vector.getSize() < fields[field].start + fields[field].length)
+    return false;
+
+  encodeValue(vector.getWritableValues(), fields[field], value);
+  return true;
+}
+
+bool FeatureSchema::encode(FeatureVector& vector, const double* field_values) const {
+  if (field_values == NULL || vector.getSize() < required_size)
+    return false;
+
+  double* values = vector.getWritableValues();
+  for (int x = 0; x < (int) fields.size(); x++)
+    encodeValue(values, fields[x], field_values[x]);
+
+  return true;
+}
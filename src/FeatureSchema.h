@@ -0,0 +1,127 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+/******************************************************************************
+ * FeatureSchema.h
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * A FeatureSchema describes how a record of real values (the fields of a
+ * state, for instance) is coded into a feature vector: each named field
+ * is coded with one of the coding functions of the FeatureVector class
+ * over its own range of vector positions. The thresholds and means of
+ * every field are computed once, when the field is added, so encoding a
+ * whole record is one pass of bulk kernels over the vector with no
+ * allocation.
+ *
+ * The thermometer and speedometer codes match the FeatureVector
+ * functions exactly. The gaussian code uses a polynomial approximation
+ * of the exponential (relative error below 1e-14).
+ *
+ *****************************************************************************/
+
+#ifndef WMTK_FEATURE_SCHEMA_H
+#define WMTK_FEATURE_SCHEMA_H
+
+#include <FeatureVector.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Enumeration of field codes.
+// Each names the FeatureVector coding function used for a field:
+// thermometerCode, gaussianCoarseCode or speedometerCoarseCode.
+enum FIELD_CODE {
+  THERMOMETER_CODE,
+  GAUSSIAN_CODE,
+  SPEEDOMETER_CODE
+};
+
+class FeatureSchema {
+
+ public:
+
+  // Constructor
+  // Creates a schema with no fields.
+  FeatureSchema();
+
+  // Copy-Constructor
+  FeatureSchema(const FeatureSchema&);
+
+  // Assignment Operator
+  FeatureSchema& operator=(const FeatureSchema&);
+
+  // Destructor
+  ~FeatureSchema();
+
+  // Adds a field coded over the vector positions from start_position to
+  // end_position (inclusive) for values from minimum to maximum, with
+  // the given variance for the gaussian code. The arguments are checked
+  // as by the FeatureVector coding functions. Returns the index of the
+  // field (its place in the records passed to encode), or -1 if the
+  // arguments are invalid or the name is already in use.
+  int addField(string name,
+	       FIELD_CODE code,
+	       int start_position,
+	       int end_position,
+	       double minimum,
+	       double maximum,
+	       double variance = 1.0);
+
+  // Returns the number of fields.
+  int getNumberOfFields() const;
+
+  // Returns the index of the named field, or -1 if there is none.
+  int getFieldIndex(string name) const;
+
+  // Returns the smallest vector size that holds every field.
+  int getRequiredSize() const;
+
+  // Codes the value of one field into the vector. Returns false if the
+  // field does not exist or the vector is too small.
+  bool encodeField(FeatureVector& vector, int field, double value) const;
+
+  // Codes a whole record into the vector: field_values holds one value
+  // per field, in the order the fields were added. Positions not
+  // covered by a field are left alone. Returns false if the vector is
+  // too small.
+  bool encode(FeatureVector& vector, const double* field_values) const;
+
+ private:
+  struct Field {
+    string name;
+    FIELD_CODE code;
+    int start; // First vector position.
+    int length; // Number of vector positions.
+    double maximum; // Top of the range (speedometer code).
+    double variance; // Variance (gaussian code).
+    int cache; // Offset of the field's thresholds or means in cache.
+  };
+
+  vector<Field> fields; // Fields, in the order added.
+  vector<double> cache; // Thresholds, means and band bounds of the fields.
+  int required_size; // Smallest vector size holding every field.
+
+  void encodeValue(double* values, const Field& field, double value) const;
+};
+
+#endif
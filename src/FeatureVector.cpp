@@ -47,8 +47,14 @@
  *****************************************************************************/
 
 #include <FeatureVector.h>
+#include <feature_kernels.h>
 #include <cstddef>
 #include <cmath>
+#include <algorithm>
+
+// Last revision number handed out. Every change to any vector takes the
+// next one, so equal revisions mean equal contents.
+static unsigned long last_revision = 0;
 
 #include <iostream>
 std::ostream& operator<<(std::ostream& os, const FeatureVector& obj) {
@@ -60,10 +66,17 @@ std::ostream& operator<<(std::ostream& os, const FeatureVector& obj) {
 FeatureVector::FeatureVector() {
   values = NULL;	// Default to clean array
   size = 0;		// Size of zero for no explicitly provided size
+  nonzero = NULL;
+  nonzero_count = -1;
+  revision = ++last_revision;
   return;
 }
 
 FeatureVector::FeatureVector(int vector_size) {
+  nonzero = NULL;
+  nonzero_count = -1;
+  revision = ++last_revision;
+
   if (vector_size < 1) {
     values = NULL;
     size = 0;
@@ -73,20 +86,21 @@ FeatureVector::FeatureVector(int vector_size) {
   size = vector_size;			//Create new vector
   values = new double[size];
 
-  for (int x = 0; x < size; x++) // Initialize values to minimum
-    values[x] = WMTK_FV_MIN;
+  fillValues(values, size, WMTK_FV_MIN); // Initialize values to minimum
 
   return;
 }
 
 FeatureVector::FeatureVector(const FeatureVector& L) : size(L.size) {
   values = NULL;
+  nonzero = NULL;
+  nonzero_count = -1;
+  revision = L.revision;	// Same contents
 
-  if (size > 1)		// Create new vector
+  if (size > 0)		// Create new vector
     values = new double[size];
 
-  for (int x = 0; x < size; x++)	// Populate vector values
-    values[x] = L.values[x];
+  copyValues(values, L.values, size);	// Populate vector values
 
   return;
 }
@@ -95,24 +109,57 @@ FeatureVector& FeatureVector::operator=(const FeatureVector& Rhs) {
 
   if (this != &Rhs) {
 
-    if (values != NULL)	// Clean old vector
-      delete [] values;
+    // The storage is kept when the sizes match.
+    if (size != Rhs.size) {
+      if (values != NULL)	// Clean old vector
+	delete [] values;
+      if (nonzero != NULL)
+	delete [] nonzero;
+      nonzero = NULL;
 
-    values = NULL;		// Set up for new size
-    size = Rhs.size;
-    if (size > 0)		// Create new vector
-      values = new double[size];
+      values = NULL;		// Set up for new size
+      size = Rhs.size;
+      if (size > 0)		// Create new vector
+	values = new double[size];
+    }
+    nonzero_count = -1;
 
-    for (int x = 0; x < size; x++)	// Populate vector values
-      values[x] = Rhs.values[x];
+    copyValues(values, Rhs.values, size);	// Populate vector values
+    revision = Rhs.revision;
 
   }
   return *this;
 }
 
+void FeatureVector::swap(FeatureVector& other) {
+  std::swap(values, other.values);
+  std::swap(size, other.size);
+  std::swap(nonzero, other.nonzero);
+  std::swap(nonzero_count, other.nonzero_count);
+  std::swap(revision, other.revision);
+}
+
+#if __cplusplus >= 201103L
+FeatureVector::FeatureVector(FeatureVector&& L) noexcept {
+  values = NULL;
+  size = 0;
+  nonzero = NULL;
+  nonzero_count = -1;
+  revision = 0;
+  swap(L);
+}
+
+FeatureVector& FeatureVector::operator=(FeatureVector&& Rhs) noexcept {
+  swap(Rhs);
+  return *this;
+}
+#endif
+
 FeatureVector::~FeatureVector() {
   if (values != NULL)	// If there was a vector, remove it
     delete [] values;
+  if (nonzero != NULL)
+    delete [] nonzero;
 
   return;
 }
@@ -128,6 +175,46 @@ double FeatureVector::getValue(int position) const {
   return values[position]; 	// Return the requested value
 }
 
+unsigned long FeatureVector::getRevision() const {
+  return revision;
+}
+
+void FeatureVector::changed() {
+  nonzero_count = -1;
+  revision = ++last_revision;
+}
+
+const double* FeatureVector::getValues() const {
+  return values;
+}
+
+const int* FeatureVector::getNonzeroIndices() const {
+  if (size == 0)
+    return NULL;
+
+  if (nonzero_count < 0) {
+    if (nonzero == NULL)
+      nonzero = new int[size];
+    nonzero_count = 0;
+    for (int x = 0; x < size; x++)
+      if (values[x] != 0.0)
+	nonzero[nonzero_count++] = x;
+  }
+
+  if (nonzero_count > WMTK_FV_SPARSE_DENSITY * size)
+    return NULL;
+
+  return nonzero;
+}
+
+int FeatureVector::getNonzeroCount() const {
+  if (size == 0)
+    return 0;
+
+  getNonzeroIndices();
+  return nonzero_count;
+}
+
 bool FeatureVector::setValue(int position, double value) {
   if (position < 0 || position >= size ||
       value < WMTK_FV_MIN || value > WMTK_FV_MAX) {
@@ -136,36 +223,69 @@ bool FeatureVector::setValue(int position, double value) {
   }
 
   values[position] = value;	// Set the requested value
+  changed();
 
   return true;
 }
 
+double* FeatureVector::getWritableValues() {
+  changed();	// The caller is about to write
+  return values;
+}
+
+void FeatureVector::clampValues() {
+  ::clampValues(values, size, WMTK_FV_MIN, WMTK_FV_MAX);
+  changed();
+}
+
+bool FeatureVector::setValues(int position, const double* source, int count) {
+  if (source == NULL || count < 0 || position < 0 || position > size - count)
+    return false;
+
+  copyValues(values + position, source, count);
+  ::clampValues(values + position, count, WMTK_FV_MIN, WMTK_FV_MAX);
+  changed();
+  return true;
+}
+
 void FeatureVector::clearVector() {
-  for (int x = 0; x < size; x++)
-    values[x] = WMTK_FV_MIN;
+  fillValues(values, size, WMTK_FV_MIN);
+  changed();
   return;
 }
 
+bool FeatureVector::copyVector(const FeatureVector& vector, int position) {
+  if (position < 0 || position > size - vector.size)
+    return false;
+
+  copyValues(values + position, vector.values, vector.size);
+  changed();
+  return true;
+}
+
+double FeatureVector::squaredDistance(const FeatureVector& vector, double limit) const {
+  if (vector.size != size)
+    return -1.0;
+
+  return ::squaredDistance(values, vector.values, size, limit);
+}
+
 bool FeatureVector::thermometerCode(int start_position, int end_position, double minimum, double maximum, double value) {
   if (start_position > end_position || minimum > maximum || start_position < 0 || end_position >= size)
     return false; // Check for out-of-range elements
 
   int x, y;
-  double* threshold = new double[(end_position - start_position) + 1];
   double step = (maximum - minimum) / ((double) (end_position - start_position));
-  // Calculate thresholds
-  for (x = 0; x < (end_position - start_position) + 1; x++)
-    threshold[x] = minimum + (((double) x) * step);
 
-  // Assign vector values
+  // Assign vector values against each threshold in turn
   x = 0;
-  for (y = start_position; y <= end_position; y++)
-    if (value >= threshold[x++])
-      setValue(y, WMTK_FV_MAX);
+  for (y = start_position; y <= end_position; y++, x++)
+    if (value >= minimum + (((double) x) * step))
+      values[y] = WMTK_FV_MAX;
     else
-      setValue(y, WMTK_FV_MIN);
+      values[y] = WMTK_FV_MIN;
 
-	delete [] threshold;
+  changed();
   return true;
 }
 
@@ -174,25 +294,18 @@ bool FeatureVector::gaussianCoarseCode(int start_position, int end_position, dou
     return false; // Check for out-of-range elements
 
   int x, y;
-  double* means = new double[(end_position - start_position) + 1];
   double step = (maximum - minimum) / ((double) (end_position - start_position));
   double scale = (WMTK_FV_MAX - WMTK_FV_MIN);
 
-  // Calculate means
-  for (x = 0; x < (end_position - start_position) + 1; x++)
-    means[x] = minimum + (((double) x) * step);
-
   // Assign vector values
-  x=0;
-  for (y = start_position; y <= end_position; y++) {
-
-    // Calculate gaussian at the position and given mean
-    setValue(y, (scale * calculateGaussian(means[x], variance, value)) + WMTK_FV_MIN);
-    x++;
-  }
+  x = 0;
+  for (y = start_position; y <= end_position; y++, x++)
+    // Calculate gaussian at the position and its mean
+    values[y] = (scale * calculateGaussian(minimum + (((double) x) * step),
+					   variance, value)) + WMTK_FV_MIN;
 
-	delete [] means;
-	return true;
+  changed();
+  return true;
 }
 
 bool FeatureVector::speedometerCoarseCode(int start_position, int end_position, double minimum, double maximum, double value) {
@@ -200,28 +313,26 @@ bool FeatureVector::speedometerCoarseCode(int start_position, int end_position,
     return false; // Check for out-of-range elements
 
   int x, y;
-  double* threshold = new double[(end_position - start_position) + 1];
   double step = (maximum - minimum) / ((double) (end_position - start_position) + 1.0);
+  double lower, upper;
 
-  // Calculate Thresholds
-  for (x = 0; x < (end_position - start_position) + 1; x++)
-    threshold[x] = minimum + (((double) x) * step);
-
-  // Assign vector values
+  // Assign vector values; each element covers one step of the range
   x = 0;
-  for (y = start_position; y < end_position; y++) {
-    if (value >= threshold[x] && value < threshold[x+1])
-      setValue(y, WMTK_FV_MAX);
+  upper = minimum;
+  for (y = start_position; y < end_position; y++, x++) {
+    lower = upper;
+    upper = minimum + (((double) (x + 1)) * step);
+    if (value >= lower && value < upper)
+      values[y] = WMTK_FV_MAX;
     else
-      setValue(y, WMTK_FV_MIN);
-    x++;
+      values[y] = WMTK_FV_MIN;
   }
-  if (value >= threshold[x] && value <= maximum)
-    setValue(y, WMTK_FV_MAX);
+  if (value >= upper && value <= maximum)
+    values[y] = WMTK_FV_MAX;
   else
-    setValue(y, WMTK_FV_MIN);
+    values[y] = WMTK_FV_MIN;
 
-  delete [] threshold;
+  changed();
   return true;
 }
 
@@ -237,19 +348,33 @@ bool FeatureVector::makeORCode(const FeatureVector& vector, const OR_CODE type)
     return false;
     break;
   case MAX_OR:
-    for (x = 0; x < getSize(); x++)
-      if (vector.getValue(x) > getValue(x))
-	setValue(x, vector.getValue(x));
+    // Elements at the minimum never raise the maximum.
+    if (vector.getNonzeroIndices() != NULL && WMTK_FV_MIN == 0.0) {
+      const int* positions = vector.getNonzeroIndices();
+      for (int y = 0; y < vector.getNonzeroCount(); y++) {
+	x = positions[y];
+	if (vector.values[x] > values[x])
+	  values[x] = vector.values[x];
+      }
+      break;
+    }
+    maxValues(values, vector.values, size);
     break;
   case NOISY_OR:
-    for (x = 0; x < getSize(); x++)
-      setValue(x, (scale * (1.0 - 
-			    ((1.0 - ((getValue(x) - WMTK_FV_MIN) / scale)) *
-			     (1.0 - ((vector.getValue(x) - WMTK_FV_MIN) / scale)))
-			    )) + WMTK_FV_MIN);
+    // Over [0,1] the scaling is the identity.
+    if (WMTK_FV_MIN == 0.0 && WMTK_FV_MAX == 1.0) {
+      noisyOrValues(values, vector.values, size);
+      break;
+    }
+    for (x = 0; x < size; x++)
+      values[x] = (scale * (1.0 -
+			    ((1.0 - ((values[x] - WMTK_FV_MIN) / scale)) *
+			     (1.0 - ((vector.values[x] - WMTK_FV_MIN) / scale)))
+			    )) + WMTK_FV_MIN;
     break;
   }
 
+  changed();
   return true;
 }
 
@@ -281,14 +406,6 @@ int FeatureVector::compare(const FeatureVector& other_vector) const {
   if (size == 0)
     return 0;
 
-  // Match individual features
-  for (int x = 0; x < size; x++) {
-    if (values[x] > other_vector.values[x])
-      return 1;
-    else if (values[x] < other_vector.values[x])
-      return -1;
-  }
-
-  // Default (they must be equal.)
-  return 0;
+  // Match individual features (zero if they are all equal)
+  return compareValues(values, other_vector.values, size);
 }
@@ -40,6 +40,13 @@
  * JLP - 5/9/04 3:08PM
  * 		Added makeORCode function and enumeration.
  *
+ * The vector also keeps (when asked for it) the list of its nonzero
+ * elements, so that mostly zero codes can be consumed without walking
+ * every element. Vectors denser than WMTK_FV_SPARSE_DENSITY fall back
+ * to dense processing. It also carries a revision number that changes
+ * with every change to its contents, so that consumers holding a copy
+ * of the elements can tell whether the copy is still current.
+ *
  *****************************************************************************/
 
 #ifndef WMTK_FEATURE_VECTOR_H
@@ -54,6 +61,10 @@
 #define WMTK_FV_MIN 0.0
 #define WMTK_FV_MAX 1.0
 
+// Fraction of nonzero elements above which a vector is treated as dense
+// (see getNonzeroIndices).
+#define WMTK_FV_SPARSE_DENSITY 0.25
+
 // Enumeration of "OR" codes.
 // Each code is used by the makeORCode function to decide how to compute the
 // "OR" of two vectors. The NO_OR flag simply ignores an attempt to "OR" the
@@ -85,6 +96,18 @@ class FeatureVector {
   // Assignment Operator
   FeatureVector& operator=(const FeatureVector&);
 
+  // Exchanges the contents of this vector with those of the provided
+  // one, without copying or allocating.
+  void swap(FeatureVector&);
+
+#if __cplusplus >= 201103L
+  // Move-Constructor and Move-Assignment
+  // Take over the contents of the source, which is left valid but
+  // unspecified.
+  FeatureVector(FeatureVector&&) noexcept;
+  FeatureVector& operator=(FeatureVector&&) noexcept;
+#endif
+
   // Destructor
   ~FeatureVector();
 
@@ -105,9 +128,56 @@ class FeatureVector {
   // zero).
   bool	setValue(int position, double value);
 
+  // Returns the contiguous storage of the vector (read-only), so that
+  // whole vectors can be consumed without per-element calls. The
+  // pointer is invalidated by assignment to the vector.
+  const double* getValues() const;
+
+  // Returns the positions of the nonzero elements, in increasing order,
+  // or NULL if there are too many of them for sparse processing to pay
+  // off. The list is built when first asked for after the vector
+  // changes and is invalidated by any change to the vector.
+  const int* getNonzeroIndices() const;
+
+  // Returns the number of nonzero elements.
+  int getNonzeroCount() const;
+
+  // Returns the revision of the contents. Every change to the vector
+  // (including a call to getWritableValues) gives it a revision that no
+  // vector has had before; copies keep the revision of their source. So
+  // two vectors with the same revision have the same elements.
+  unsigned long getRevision() const;
+
+  // Returns the writable storage of the vector (getSize() elements), so
+  // that a translation function can fill it in bulk rather than through
+  // setValue. Values written this way are not range checked until
+  // clampValues is called; the updateFeatures functions of the state
+  // and chunk vectors call it after their translation function returns.
+  // The pointer is invalidated by assignment to the vector.
+  double* getWritableValues();
+
+  // Limits every element to [WMTK_FV_MIN, WMTK_FV_MAX] in one pass.
+  void	clampValues();
+
+  // Copies count values into the vector starting at the specified
+  // position, limiting them to [WMTK_FV_MIN, WMTK_FV_MAX]. Returns false
+  // if they do not fit.
+  bool	setValues(int position, const double* source, int count);
+
   // Sets the vector elements to their minimum values.
   void	clearVector();
 
+  // Copies the elements of the provided vector into this vector,
+  // starting at the specified position. Returns false if they do not
+  // fit.
+  bool	copyVector(const FeatureVector& vector, int position = 0);
+
+  // Returns the squared Euclidean distance between this vector and the
+  // provided vector (which must be the same size), or -1.0 if the sizes
+  // differ. Once the distance is known to exceed limit, the sum stops
+  // and some value above limit is returned.
+  double squaredDistance(const FeatureVector& vector, double limit) const;
+
   // This function encodes the value provided in thermometer code within
   // the specified range of vector positions (inclusive) while scaling
   // according to the minimum and maximum provided. The final individual
@@ -152,6 +222,12 @@ class FeatureVector {
  private:
   double* values; // Vector of real values for coding values.
   int size; // Size of the vector.
+  mutable int* nonzero; // Positions of the nonzero values.
+  mutable int nonzero_count; // Number of those, or -1 if not current.
+  unsigned long revision; // Revision of the contents.
+
+  // Records a change to the contents (see getRevision).
+  void changed();
 
   // This function computes the value of a gaussian function with the
   // provided mean and variance.
@@ -0,0 +1,373 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+/******************************************************************************
+ * HiddenTDCritic.cpp
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * This class is a critic engine with layers of nonlinear hidden units,
+ * trained by TD(lambda) with backpropagated eligibility traces.
+ *
+ *****************************************************************************/
+
+#include <HiddenTDCritic.h>
+#include <random_number_generator.h>
+#include <uniform_random_number_generator.h>
+#include <cstddef>
+#include <cmath>
+#include <fstream>
+
+void HiddenTDCritic::init() {
+  size = 0;
+  layers = 0;
+  layer_sizes = NULL;
+  activation = TANH_ACTIVATION;
+  parameter_size = 0;
+  unit_size = 0;
+  parameters = NULL;
+  traces = NULL;
+  acts = NULL;
+  deltas = NULL;
+}
+
+void HiddenTDCritic::dispose() {
+  if (layer_sizes != NULL)
+    delete [] layer_sizes;
+  storage.release();
+  init();
+}
+
+void HiddenTDCritic::layoutStorage() {
+  parameters = storage.at(0);
+  traces = storage.at(parameter_size);
+  acts = storage.at(2 * parameter_size);
+  deltas = storage.at((2 * parameter_size) + unit_size);
+}
+
+void HiddenTDCritic::copy(const HiddenTDCritic& src) {
+  TDCritic::operator=(src);
+  size = src.size;
+  layers = src.layers;
+  if (src.layer_sizes != NULL) {
+    layer_sizes = new int[layers];
+    for (int x = 0; x < layers; x++)
+      layer_sizes[x] = src.layer_sizes[x];
+  }
+  activation = src.activation;
+  parameter_size = src.parameter_size;
+  unit_size = src.unit_size;
+  storage = src.storage;
+  if (parameter_size > 0)
+    layoutStorage();
+}
+
+HiddenTDCritic::HiddenTDCritic() : TDCritic() {
+  init();
+}
+
+HiddenTDCritic::HiddenTDCritic(int input_size, int number_of_layers, const int* sizes, HIDDEN_ACTIVATION activation_function, double discount_rate, double lambda_value, double learning_rate_value) : TDCritic(discount_rate, lambda_value, learning_rate_value) {
+  init();
+
+  int x;
+  int in_size = input_size;
+
+  if (input_size < 1 || number_of_layers < 1 || sizes == NULL)
+    return;
+  for (x = 0; x < number_of_layers; x++)
+    if (sizes[x] < 1)
+      return;
+
+  size = input_size;
+  layers = number_of_layers;
+  layer_sizes = new int[layers];
+  activation = activation_function;
+  for (x = 0; x < layers; x++) {
+    layer_sizes[x] = sizes[x];
+    parameter_size += (in_size + 1) * layer_sizes[x];
+    unit_size += layer_sizes[x];
+    in_size = layer_sizes[x];
+  }
+  parameter_size += in_size + 1;
+
+  // Allocated zeroed.
+  storage.allocate((2 * parameter_size) + (2 * unit_size));
+  layoutStorage();
+}
+
+HiddenTDCritic::HiddenTDCritic(const HiddenTDCritic& L) : TDCritic(L) {
+  init();
+  copy(L);
+}
+
+HiddenTDCritic::~HiddenTDCritic() {
+  dispose();
+}
+
+HiddenTDCritic& HiddenTDCritic::operator=(const HiddenTDCritic& Rhs) {
+  if (this != &Rhs) {
+    dispose();
+    copy(Rhs);
+  }
+  return *this;
+}
+
+TDCritic* HiddenTDCritic::clone() const {
+  return new HiddenTDCritic(*this);
+}
+
+int HiddenTDCritic::getInputSize() const {
+  return size;
+}
+
+int HiddenTDCritic::getNumberOfLayers() const {
+  return layers;
+}
+
+int HiddenTDCritic::getLayerSize(int layer) const {
+  if (layer < 0 || layer >= layers)
+    return 0;
+  return layer_sizes[layer];
+}
+
+int HiddenTDCritic::getNumberOfParameters() const {
+  return parameter_size;
+}
+
+double HiddenTDCritic::activate(double net) const {
+  switch (activation) {
+  case SIGMOID_ACTIVATION:
+    return 1.0 / (1.0 + exp(-net));
+  case RELU_ACTIVATION:
+    return net > 0.0 ? net : 0.0;
+  case TANH_ACTIVATION:
+  default:
+    return tanh(net);
+  }
+}
+
+// The derivatives are written in terms of the activation itself.
+double HiddenTDCritic::derivative(double act) const {
+  switch (activation) {
+  case SIGMOID_ACTIVATION:
+    return act * (1.0 - act);
+  case RELU_ACTIVATION:
+    return act > 0.0 ? 1.0 : 0.0;
+  case TANH_ACTIVATION:
+  default:
+    return 1.0 - (act * act);
+  }
+}
+
+bool HiddenTDCritic::initializeWeights(RandomNumberGenerator& rng) {
+  if (parameters == NULL)
+    return false;
+
+  int x, y, l;
+  int in_size = size;
+  double* p = parameters;
+  double limit;
+
+  for (l = 0; l < layers; l++) {
+    limit = sqrt(6.0 / (in_size + layer_sizes[l]));
+    UniformRandomNumberGenerator layer_rng(-limit, limit);
+    for (x = 0; x < in_size; x++)
+      for (y = 0; y < layer_sizes[l]; y++)
+	*(p++) = layer_rng.Number();
+    for (y = 0; y < layer_sizes[l]; y++)
+      *(p++) = 0.0;
+    in_size = layer_sizes[l];
+  }
+
+  limit = sqrt(6.0 / (in_size + 1));
+  UniformRandomNumberGenerator output_rng(-limit, limit);
+  for (x = 0; x < in_size; x++)
+    *(p++) = output_rng.Number();
+  *p = rng.Number();
+
+  return true;
+}
+
+bool HiddenTDCritic::clearEligibilityTraces() {
+  if (traces == NULL)
+    return false;
+
+  for (int x = 0; x < parameter_size; x++)
+    traces[x] = 0.0;
+
+  return true;
+}
+
+// Leaves the activations of the hidden units in units. When nonzero is
+// not NULL, it lists the count nonzero inputs.
+double HiddenTDCritic::forward(const double* inputs, const int* nonzero, int count, double* units) const {
+  int x, y, l, n;
+  int in_size = size;
+  int out_size;
+  const double* in = inputs;
+  const double* p = parameters;
+  const double* row;
+  double* h = units;
+  double value;
+
+  for (l = 0; l < layers; l++) {
+    out_size = layer_sizes[l];
+    const double* bias = p + (in_size * out_size);
+
+    for (y = 0; y < out_size; y++)
+      h[y] = bias[y];
+    if (l == 0 && nonzero != NULL)
+      for (n = 0; n < count; n++) {
+	x = nonzero[n];
+	row = p + (x * out_size);
+	for (y = 0; y < out_size; y++)
+	  h[y] += in[x] * row[y];
+      }
+    else
+      for (x = 0; x < in_size; x++) {
+	if (in[x] == 0.0)
+	  continue;
+	row = p + (x * out_size);
+	for (y = 0; y < out_size; y++)
+	  h[y] += in[x] * row[y];
+      }
+    for (y = 0; y < out_size; y++)
+      h[y] = activate(h[y]);
+
+    p = bias + out_size;
+    in = h;
+    in_size = out_size;
+    h += out_size;
+  }
+
+  value = p[in_size];
+  for (x = 0; x < in_size; x++)
+    value += p[x] * in[x];
+
+  return value;
+}
+
+double HiddenTDCritic::evaluate(const double* inputs) const {
+  if (parameters == NULL || inputs == NULL)
+    return 0.0;
+
+  // A const evaluation keeps its activations to itself rather than in
+  // acts.
+  double* units = new double[unit_size];
+  double value = forward(inputs, NULL, 0, units);
+  delete [] units;
+  return value;
+}
+
+double HiddenTDCritic::evaluateSparse(const double* inputs, const int* nonzero, int count) const {
+  if (parameters == NULL || inputs == NULL)
+    return 0.0;
+
+  double* units = new double[unit_size];
+  double value = forward(inputs, nonzero, count, units);
+  delete [] units;
+  return value;
+}
+
+double HiddenTDCritic::tdUpdate(const double* last_inputs, double last_value, const double* next_inputs, double next_value, double reward, bool absorb_reward) {
+  if (parameters == NULL || last_inputs == NULL || next_inputs == NULL)
+    return 0.0;
+
+  computeTDError(last_value, next_value, reward, absorb_reward);
+  forward(last_inputs, NULL, 0, acts);
+
+  int x, y, l;
+  int in_size, out_size;
+  int offset = parameter_size - (layer_sizes[layers - 1] + 1);
+  int unit_offset = unit_size - layer_sizes[layers - 1];
+  double decay = gamma * lambda;
+  double step = learning_rate * td_error;
+  double sum;
+  const double* in;
+  const double* w;
+  double* t;
+  double* d;
+
+  // Output unit: the gradient is the last hidden layer's activation.
+  in = acts + unit_offset;
+  w = parameters + offset;
+  t = traces + offset;
+  d = deltas + unit_offset;
+  for (y = 0; y < layer_sizes[layers - 1]; y++) {
+    t[y] = (decay * t[y]) + in[y];
+    d[y] = w[y] * derivative(in[y]);
+  }
+  t[y] = (decay * t[y]) + 1.0;
+
+  // Hidden layers, from the output side: fold each layer's gradient into
+  // its traces and pass the deltas back through its weights (before any
+  // of them change).
+  for (l = layers - 1; l >= 0; l--) {
+    out_size = layer_sizes[l];
+    in_size = (l == 0) ? size : layer_sizes[l - 1];
+    offset -= (in_size + 1) * out_size;
+    in = (l == 0) ? last_inputs : acts + unit_offset - in_size;
+    w = parameters + offset;
+    t = traces + offset;
+    d = deltas + unit_offset;
+
+    for (x = 0; x < in_size; x++, t += out_size, w += out_size) {
+      for (y = 0; y < out_size; y++)
+	t[y] = (decay * t[y]) + (in[x] * d[y]);
+      if (l > 0) {
+	sum = 0.0;
+	for (y = 0; y < out_size; y++)
+	  sum += w[y] * d[y];
+	deltas[unit_offset - in_size + x] = sum * derivative(in[x]);
+      }
+    }
+    for (y = 0; y < out_size; y++)
+      t[y] = (decay * t[y]) + d[y];
+
+    unit_offset -= in_size;
+  }
+
+  for (x = 0; x < parameter_size; x++)
+    parameters[x] += step * traces[x];
+
+  return evaluate(next_inputs);
+}
+
+bool HiddenTDCritic::writeWeights(ofstream& file_stream) {
+  if (parameters == NULL)
+    return false;
+
+  for (int x = 0; x < parameter_size; x++)
+    file_stream << parameters[x] << " " << endl;
+
+  return true;
+}
+
+bool HiddenTDCritic::readWeights(ifstream& file_stream) {
+  if (parameters == NULL)
+    return false;
+
+  for (int x = 0; x < parameter_size; x++)
+    file_stream >> parameters[x];
+
+  return true;
+}
@@ -0,0 +1,160 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+/******************************************************************************
+ * HiddenTDCritic.h
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * This class is a critic engine with one or more layers of nonlinear
+ * hidden units between the input vector and the single linear output
+ * unit. The hidden units can represent the interactions between the
+ * state and the chunks (and between the chunks) that the linear critic
+ * only sees through the conjunctive codes, whose size grows with the
+ * product of the chunk vector sizes. Fed with the CONCAT code, the
+ * parameters and the cost of an evaluation grow with the hidden layer
+ * sizes instead.
+ *
+ * Learning is TD(lambda) with one eligibility trace per parameter: the
+ * gradient of the value of the last input vector is backpropagated
+ * through the layers, added to the decayed traces, and the parameters
+ * are moved along the traces by the TD error.
+ *
+ * Each layer's weights are stored input-major (the weights out of one
+ * input unit are contiguous), so an input unit that is zero costs
+ * nothing during an evaluation. All of the numeric state sits in a
+ * single NumericArena: the parameters (each hidden layer's weights and
+ * biases, then the output weights and bias), the traces in the same
+ * order, and the activations and deltas of the hidden units.
+ *
+ *****************************************************************************/
+
+#ifndef WMTK_HIDDEN_TD_CRITIC_H
+#define WMTK_HIDDEN_TD_CRITIC_H
+
+#include <TDCritic.h>
+#include <CriticNetwork.h>
+#include <numeric_arena.h>
+#include <fstream>
+
+using namespace std;
+
+class RandomNumberGenerator;
+
+class HiddenTDCritic : public TDCritic {
+
+ public:
+
+  // Constructor
+  HiddenTDCritic();
+
+  // Constructor
+  // Creates a critic for input vectors of the specified size with
+  // number_of_layers hidden layers, the sizes of which are listed in
+  // layer_sizes (from the input side), all using the given activation
+  // function.
+  HiddenTDCritic(int input_size,
+		 int number_of_layers,
+		 const int* layer_sizes,
+		 HIDDEN_ACTIVATION activation_function,
+		 double discount_rate,
+		 double lambda_value,
+		 double learning_rate_value);
+
+  // Copy-Constructor
+  HiddenTDCritic(const HiddenTDCritic&);
+
+  // Destructor
+  ~HiddenTDCritic();
+
+  // Assignment Operator
+  HiddenTDCritic& operator=(const HiddenTDCritic&);
+
+  // Returns a newly allocated copy of this critic.
+  TDCritic* clone() const;
+
+  // Returns the size of the input vectors.
+  int getInputSize() const;
+
+  // Returns the number of hidden layers and the size of one of them.
+  int getNumberOfLayers() const;
+  int getLayerSize(int layer) const;
+
+  // Returns the number of parameters.
+  int getNumberOfParameters() const;
+
+  // Draws the weights of each layer uniformly from a range scaled to the
+  // layer's fan-in and fan-out, so that the hidden units start out
+  // distinct and away from saturation. The output bias is drawn from the
+  // provided RandomNumberGenerator, so the initial values are centered on
+  // its draws as those of the linear critic are.
+  bool initializeWeights(RandomNumberGenerator& rng);
+
+  // Clears the eligibility traces.
+  bool clearEligibilityTraces();
+
+  // Returns the value of the provided input vector.
+  double evaluate(const double* inputs) const;
+
+  // Returns the value of a sparse input vector (visiting only the
+  // weights out of its nonzero elements in the first layer).
+  double evaluateSparse(const double* inputs, const int* nonzero,
+			int count) const;
+
+  // Performs one TD(lambda) step for the transition from last_inputs to
+  // next_inputs. Returns the value of next_inputs under the updated
+  // parameters.
+  double tdUpdate(const double* last_inputs,
+		  double last_value,
+		  const double* next_inputs,
+		  double next_value,
+		  double reward,
+		  bool absorb_reward);
+
+  // Writes/reads the parameters, one per line, in storage order.
+  bool writeWeights(ofstream& file_stream);
+  bool readWeights(ifstream& file_stream);
+
+ private:
+  int size; // Size of the input vectors.
+  int layers; // Number of hidden layers.
+  int* layer_sizes; // Size of each hidden layer.
+  HIDDEN_ACTIVATION activation; // Activation function of the hidden units.
+  int parameter_size; // Number of parameters.
+  int unit_size; // Number of hidden units.
+  NumericArena storage; // Parameters, traces, activations and deltas.
+  double* parameters; // Parameters, layer by layer (in storage).
+  double* traces; // Eligibility traces, laid out as the parameters.
+  double* acts; // Activations of the hidden units, for tdUpdate only.
+  double* deltas; // Gradient of the value at each hidden unit's net input.
+
+  void init();
+  void dispose();
+  void copy(const HiddenTDCritic&);
+  void layoutStorage();
+  double forward(const double* inputs, const int* nonzero, int count,
+		 double* units) const;
+  double activate(double net) const;
+  double derivative(double act) const;
+};
+
+#endif
@@ -0,0 +1,319 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+/******************************************************************************
+ * LinearTDCritic.cpp
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * This class is a specialized engine for the critic used by the
+ * CriticNetwork class: a single linear unit with a bias, trained by
+ * TD(lambda). Rather than building layers and projections of neural
+ * units, the weights and eligibility traces are held in contiguous
+ * vectors and the evaluation and learning steps are simple loops over
+ * them.
+ *
+ *****************************************************************************/
+
+#include <LinearTDCritic.h>
+#include <random_number_generator.h>
+#include <cstddef>
+#include <fstream>
+
+void LinearTDCritic::init() {
+  size = 0;
+  weights = NULL;
+  traces = NULL;
+  active = NULL;
+  active_count = 0;
+  merge_work = NULL;
+}
+
+void LinearTDCritic::dispose() {
+  storage.release();
+  if (active != NULL)
+    delete [] active;
+  if (merge_work != NULL)
+    delete [] merge_work;
+  init();
+}
+
+void LinearTDCritic::layoutStorage() {
+  weights = storage.at(0);
+  traces = storage.at(size + 1);
+}
+
+void LinearTDCritic::copy(const LinearTDCritic& src) {
+  TDCritic::operator=(src);
+  size = src.size;
+  storage = src.storage;
+  if (size > 0) {
+    layoutStorage();
+    active = new int[size];
+    merge_work = new int[size];
+    active_count = src.active_count;
+    for (int x = 0; x < active_count; x++)
+      active[x] = src.active[x];
+  }
+}
+
+LinearTDCritic::LinearTDCritic() : TDCritic() {
+  init();
+}
+
+LinearTDCritic::LinearTDCritic(int input_size, double discount_rate, double lambda_value, double learning_rate_value) : TDCritic(discount_rate, lambda_value, learning_rate_value) {
+  init();
+
+  if (input_size < 1)
+    return;
+
+  size = input_size;
+
+  // Allocated zeroed.
+  storage.allocate(2 * (size + 1));
+  layoutStorage();
+  active = new int[size];
+  merge_work = new int[size];
+}
+
+LinearTDCritic::LinearTDCritic(const LinearTDCritic& L) : TDCritic(L) {
+  init();
+  copy(L);
+}
+
+LinearTDCritic::~LinearTDCritic() {
+  dispose();
+}
+
+LinearTDCritic& LinearTDCritic::operator=(const LinearTDCritic& Rhs) {
+  if (this != &Rhs) {
+    if (active != NULL)
+      delete [] active;
+    if (merge_work != NULL)
+      delete [] merge_work;
+    init();
+    copy(Rhs);
+  }
+  return *this;
+}
+
+TDCritic* LinearTDCritic::clone() const {
+  return new LinearTDCritic(*this);
+}
+
+int LinearTDCritic::getInputSize() const {
+  return size;
+}
+
+bool LinearTDCritic::initializeWeights(RandomNumberGenerator& rng) {
+  if (weights == NULL)
+    return false;
+
+  // Input weights, then the bias weight.
+  for (int x = 0; x <= size; x++)
+    weights[x] = rng.Number();
+
+  return true;
+}
+
+bool LinearTDCritic::clearEligibilityTraces() {
+  if (traces == NULL)
+    return false;
+
+  for (int x = 0; x <= size; x++)
+    traces[x] = 0.0;
+  active_count = 0;
+
+  return true;
+}
+
+double LinearTDCritic::evaluate(const double* inputs) const {
+  if (weights == NULL || inputs == NULL)
+    return 0.0;
+
+  double value = weights[size];
+
+  for (int x = 0; x < size; x++)
+    value += weights[x] * inputs[x];
+
+  return value;
+}
+
+double LinearTDCritic::evaluateSparse(const double* inputs, const int* nonzero, int count) const {
+  if (weights == NULL || inputs == NULL)
+    return 0.0;
+  if (nonzero == NULL)
+    return evaluate(inputs);
+
+  double value = weights[size];
+
+  for (int y = 0; y < count; y++)
+    value += weights[nonzero[y]] * inputs[nonzero[y]];
+
+  return value;
+}
+
+void LinearTDCritic::evaluateBatch(int count, const double* const* inputs, double* values) const {
+  if (weights == NULL || inputs == NULL || values == NULL)
+    return;
+
+  int x, y;
+  double w;
+  double bias = weights[size];
+
+  // Four vectors at a time, so that each weight is loaded once for all
+  // of them.
+  for (y = 0; y + 4 <= count; y += 4) {
+    const double* in0 = inputs[y];
+    const double* in1 = inputs[y+1];
+    const double* in2 = inputs[y+2];
+    const double* in3 = inputs[y+3];
+    double v0 = bias, v1 = bias, v2 = bias, v3 = bias;
+    for (x = 0; x < size; x++) {
+      w = weights[x];
+      v0 += w * in0[x];
+      v1 += w * in1[x];
+      v2 += w * in2[x];
+      v3 += w * in3[x];
+    }
+    values[y] = v0;
+    values[y+1] = v1;
+    values[y+2] = v2;
+    values[y+3] = v3;
+  }
+
+  for (; y < count; y++)
+    values[y] = evaluate(inputs[y]);
+}
+
+double LinearTDCritic::tdUpdate(const double* last_inputs, double last_value, const double* next_inputs, double next_value, double reward, bool absorb_reward) {
+  if (weights == NULL || last_inputs == NULL || next_inputs == NULL)
+    return 0.0;
+
+  computeTDError(last_value, next_value, reward, absorb_reward);
+
+  int x;
+  double decay = gamma * lambda;
+  double step = learning_rate * td_error;
+  double change = 0.0;
+  double d_weight;
+
+  // Single streaming pass: trace decay, gradient, weight change, and the
+  // resulting change in the value of next_inputs.
+  active_count = 0;
+  for (x = 0; x < size; x++) {
+    traces[x] = (decay * traces[x]) + last_inputs[x];
+    d_weight = step * traces[x];
+    weights[x] += d_weight;
+    change += d_weight * next_inputs[x];
+    if (traces[x] != 0.0)
+      active[active_count++] = x;
+  }
+
+  // The bias unit's activation is always 1.
+  traces[size] = (decay * traces[size]) + 1.0;
+  d_weight = step * traces[size];
+  weights[size] += d_weight;
+  change += d_weight;
+
+  return next_value + change;
+}
+
+double LinearTDCritic::tdUpdateSparse(const double* last_inputs, const int* last_nonzero, int last_count, double last_value, const double* next_inputs, double next_value, double reward, bool absorb_reward) {
+  if (last_nonzero == NULL)
+    return tdUpdate(last_inputs, last_value, next_inputs, next_value,
+		    reward, absorb_reward);
+  if (weights == NULL || last_inputs == NULL || next_inputs == NULL)
+    return 0.0;
+
+  computeTDError(last_value, next_value, reward, absorb_reward);
+
+  int x, y, z, n;
+  double decay = gamma * lambda;
+  double step = learning_rate * td_error;
+  double change = 0.0;
+  double d_weight;
+
+  // Every other weight has a zero trace and a zero input, so its trace,
+  // weight and contribution to the change stay zero. Merging the two
+  // ordered lists keeps the order (and so the sums) of the dense pass.
+  n = 0;
+  for (y = 0, z = 0; y < active_count || z < last_count; ) {
+    if (z == last_count ||
+	(y < active_count && active[y] < last_nonzero[z]))
+      merge_work[n++] = active[y++];
+    else if (y == active_count || last_nonzero[z] < active[y])
+      merge_work[n++] = last_nonzero[z++];
+    else {
+      merge_work[n++] = active[y++];
+      z++;
+    }
+  }
+
+  active_count = 0;
+  for (y = 0; y < n; y++) {
+    x = merge_work[y];
+    traces[x] = (decay * traces[x]) + last_inputs[x];
+    d_weight = step * traces[x];
+    weights[x] += d_weight;
+    change += d_weight * next_inputs[x];
+    if (traces[x] != 0.0)
+      active[active_count++] = x;
+  }
+
+  // The bias unit's activation is always 1.
+  traces[size] = (decay * traces[size]) + 1.0;
+  d_weight = step * traces[size];
+  weights[size] += d_weight;
+  change += d_weight;
+
+  return next_value + change;
+}
+
+const double* LinearTDCritic::getWeights() const {
+  return weights;
+}
+
+double LinearTDCritic::getBias() const {
+  if (weights == NULL)
+    return 0.0;
+  return weights[size];
+}
+
+bool LinearTDCritic::writeWeights(ofstream& file_stream) {
+  if (weights == NULL)
+    return false;
+
+  for (int x = 0; x <= size; x++)
+    file_stream << weights[x] << " " << endl;
+
+  return true;
+}
+
+bool LinearTDCritic::readWeights(ifstream& file_stream) {
+  if (weights == NULL)
+    return false;
+
+  for (int x = 0; x <= size; x++)
+    file_stream >> weights[x];
+
+  return true;
+}
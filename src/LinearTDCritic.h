@@ -0,0 +1,158 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+/******************************************************************************
+ * LinearTDCritic.h
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * This class is a specialized engine for the critic used by the
+ * CriticNetwork class: a single linear unit with a bias, trained by
+ * TD(lambda). Rather than building layers and projections of neural
+ * units, the weights and eligibility traces are held in contiguous
+ * vectors and the evaluation and learning steps are simple loops over
+ * them. The weight file format matches the one written by the layered
+ * critic (one input weight per line followed by the bias weight).
+ *
+ * All of the numeric state sits in a single NumericArena: the input
+ * weights followed by the bias weight, then the traces in the same
+ * order. Copying a critic is one block copy.
+ *
+ * The critic also keeps the list of its nonzero traces, so that for
+ * sparse inputs a learning step only touches the weights whose traces
+ * are nonzero (those of the inputs seen since the traces last decayed
+ * to zero) rather than every weight.
+ *
+ *****************************************************************************/
+
+#ifndef WMTK_LINEAR_TD_CRITIC_H
+#define WMTK_LINEAR_TD_CRITIC_H
+
+#include <TDCritic.h>
+#include <numeric_arena.h>
+#include <fstream>
+
+using namespace std;
+
+class RandomNumberGenerator;
+
+class LinearTDCritic : public TDCritic {
+
+ public:
+
+  // Constructor
+  LinearTDCritic();
+
+  // Constructor
+  // Creates a critic for input vectors of the specified size.
+  LinearTDCritic(int input_size,
+		 double discount_rate,
+		 double lambda_value,
+		 double learning_rate_value);
+
+  // Copy-Constructor
+  LinearTDCritic(const LinearTDCritic&);
+
+  // Destructor
+  ~LinearTDCritic();
+
+  // Assignment Operator
+  LinearTDCritic& operator=(const LinearTDCritic&);
+
+  // Returns a newly allocated copy of this critic.
+  TDCritic* clone() const;
+
+  // Returns the size of the input vectors.
+  int getInputSize() const;
+
+  // Draws the input and bias weights (in that order) from the provided
+  // RandomNumberGenerator.
+  bool initializeWeights(RandomNumberGenerator& rng);
+
+  // Clears the eligibility traces.
+  bool clearEligibilityTraces();
+
+  // Returns the value of the provided input vector.
+  double evaluate(const double* inputs) const;
+
+  // Computes the values of several input vectors at once, sharing each
+  // weight load between the vectors.
+  void evaluateBatch(int count, const double* const* inputs,
+		     double* values) const;
+
+  // Returns the value of a sparse input vector (gathering the weights
+  // of its nonzero elements).
+  double evaluateSparse(const double* inputs, const int* nonzero,
+			int count) const;
+
+  // Performs one TD(lambda) step for the transition from last_inputs
+  // (whose value was last_value) to next_inputs (whose value is
+  // next_value). When absorb_reward is set, the transition is into a
+  // terminal state and next_value is ignored for the TD error. The
+  // traces are decayed, the gradient of last_inputs is added, and the
+  // weights are changed in a single pass. Returns the value of
+  // next_inputs under the updated weights, computed from the weight
+  // change rather than another evaluation.
+  double tdUpdate(const double* last_inputs,
+		  double last_value,
+		  const double* next_inputs,
+		  double next_value,
+		  double reward,
+		  bool absorb_reward);
+
+  // Performs the same step for a sparse last_inputs, visiting only the
+  // weights with nonzero traces or nonzero inputs. The results are
+  // identical to those of tdUpdate.
+  double tdUpdateSparse(const double* last_inputs,
+			const int* last_nonzero,
+			int last_count,
+			double last_value,
+			const double* next_inputs,
+			double next_value,
+			double reward,
+			bool absorb_reward);
+
+  // Returns the input weights (read-only, one per input) and the bias
+  // weight, for callers that compute the value of structured inputs
+  // themselves.
+  const double* getWeights() const;
+  double getBias() const;
+
+  // Writes/reads the weights (same format as the layered critic).
+  bool writeWeights(ofstream& file_stream);
+  bool readWeights(ifstream& file_stream);
+
+ private:
+  int size; // Size of the input vectors.
+  NumericArena storage; // Weights and traces.
+  double* weights; // Input weights, then the bias weight (in storage).
+  double* traces; // Eligibility traces, laid out as the weights.
+  int* active; // Positions of the nonzero input traces, in order.
+  int active_count; // Number of those.
+  int* merge_work; // Room for merging the active and input positions.
+
+  void init();
+  void dispose();
+  void copy(const LinearTDCritic&);
+  void layoutStorage();
+};
+
+#endif
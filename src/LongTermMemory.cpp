@@ -0,0 +1,219 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+/******************************************************************************
+ * LongTermMemory.cpp
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * The LongTermMemory class is a store of chunks from which candidates for
+ * working memory can be retrieved by the dot products of their feature
+ * vectors with a cue.
+ *
+ *****************************************************************************/
+
+#include <LongTermMemory.h>
+#include <FeatureVector.h>
+#include <numeric_arena.h>
+#include <feature_kernels.h>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+
+// Number of feature vectors scored at a time during retrieval.
+#define RETRIEVAL_BLOCK 256
+
+// Orders retrieval results best first: by larger dot product, then by
+// smaller index.
+static bool betterResult(const pair<double, int>& a, const pair<double, int>& b) {
+  return a.first > b.first || (a.first == b.first && a.second < b.second);
+}
+
+void LongTermMemory::init() {
+  vector_size = 0;
+  capacity = 0;
+  features = NULL;
+}
+
+void LongTermMemory::dispose() {
+  if (features != NULL)
+    delete features;
+  chunks.clear();
+  init();
+}
+
+void LongTermMemory::copy(const LongTermMemory& src) {
+  vector_size = src.vector_size;
+  capacity = src.capacity;
+  if (src.features != NULL)
+    features = new NumericArena(*src.features);
+  chunks = src.chunks;
+}
+
+LongTermMemory::LongTermMemory() {
+  init();
+}
+
+LongTermMemory::LongTermMemory(int feature_vector_size) {
+  init();
+
+  if (feature_vector_size < 1)
+    return;
+
+  vector_size = feature_vector_size;
+  features = new NumericArena();
+}
+
+LongTermMemory::LongTermMemory(const LongTermMemory& L) {
+  init();
+  copy(L);
+}
+
+LongTermMemory::~LongTermMemory() {
+  dispose();
+}
+
+LongTermMemory& LongTermMemory::operator=(const LongTermMemory& Rhs) {
+  if (this != &Rhs) {
+    dispose();
+    copy(Rhs);
+  }
+  return *this;
+}
+
+void LongTermMemory::swap(LongTermMemory& other) {
+  std::swap(vector_size, other.vector_size);
+  std::swap(capacity, other.capacity);
+  std::swap(features, other.features);
+  chunks.swap(other.chunks);
+}
+
+int LongTermMemory::getFeatureVectorSize() const {
+  return vector_size;
+}
+
+int LongTermMemory::getNumberOfChunks() const {
+  return chunks.size();
+}
+
+// Grows the block (at least doubling it) to hold number_of_vectors
+// feature vectors.
+bool LongTermMemory::reserve(int number_of_vectors) {
+  if (number_of_vectors <= capacity)
+    return true;
+
+  // Sizes and offsets in the block are taken in size_t, as a million
+  // vectors of a few thousand features overflow an int.
+  int new_capacity = max(number_of_vectors, 2 * capacity);
+  size_t width = vector_size;
+  NumericArena block;
+
+  if (!block.allocate(new_capacity * width))
+    return false;
+  if (!chunks.empty())
+    memcpy(block.at(0), features->at(0),
+	   chunks.size() * width * sizeof(double));
+
+  features->swap(block);
+  capacity = new_capacity;
+  return true;
+}
+
+int LongTermMemory::storeChunk(const Chunk& chunk, const FeatureVector& features_of_chunk) {
+  if (features == NULL || features_of_chunk.getSize() != vector_size ||
+      !reserve(chunks.size() + 1))
+    return -1;
+
+  copyValues(features->at(chunks.size() * (size_t) vector_size),
+	     features_of_chunk.getValues(), vector_size);
+  chunks.push_back(chunk);
+
+  return chunks.size() - 1;
+}
+
+Chunk LongTermMemory::getChunk(int index) const {
+  Chunk result;
+  int stored = chunks.size();
+
+  if (index < 0 || index >= stored)
+    return result;
+
+  return chunks[index];
+}
+
+const double* LongTermMemory::getFeatures(int index) const {
+  int stored = chunks.size();
+
+  if (index < 0 || index >= stored)
+    return NULL;
+
+  return features->at((size_t) index * vector_size);
+}
+
+int LongTermMemory::retrieve(const double* cue, int count, int* indices, double* scores) const {
+  if (features == NULL || cue == NULL || indices == NULL || count < 1)
+    return 0;
+
+  int stored = chunks.size();
+  int first, block, x;
+  int found = 0;
+  double products[RETRIEVAL_BLOCK];
+  pair<double, int> result;
+
+  // The results are kept in a heap with the worst of them on top, so
+  // each vector is compared with the worst result only.
+  vector< pair<double, int> > best;
+  best.reserve(count);
+
+  for (first = 0; first < stored; first += RETRIEVAL_BLOCK) {
+    block = min(RETRIEVAL_BLOCK, stored - first);
+    dotProducts(features->at((size_t) first * vector_size), block,
+		vector_size, cue, products);
+    for (x = 0; x < block; x++) {
+      result = make_pair(products[x], first + x);
+      if (found < count) {
+	best.push_back(result);
+	found++;
+	push_heap(best.begin(), best.end(), betterResult);
+      }
+      else if (betterResult(result, best.front())) {
+	pop_heap(best.begin(), best.end(), betterResult);
+	best.back() = result;
+	push_heap(best.begin(), best.end(), betterResult);
+      }
+    }
+  }
+
+  sort_heap(best.begin(), best.end(), betterResult);
+  for (x = 0; x < found; x++) {
+    indices[x] = best[x].second;
+    if (scores != NULL)
+      scores[x] = best[x].first;
+  }
+
+  return found;
+}
+
+void LongTermMemory::clear() {
+  chunks.clear();
+}
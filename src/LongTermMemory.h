@@ -0,0 +1,124 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+/******************************************************************************
+ * LongTermMemory.h
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * The LongTermMemory class is a store of chunks from which candidates for
+ * working memory can be retrieved, so that the user does not have to
+ * choose the candidates for every time step. Each stored chunk is kept
+ * with its feature vector, and the feature vectors sit one after the
+ * other in a single contiguous block, so that retrieval is one pass over
+ * the block: the chunks whose feature vectors have the largest dot
+ * products with a cue vector are retrieved.
+ *
+ * A WorkingMemory object can be given a long-term memory (see
+ * WorkingMemory::setLongTermMemory), in which case it retrieves
+ * candidates from it at every time step with a cue built from the state.
+ * The stored chunks are copied into the candidate list, so their data is
+ * shared with the store.
+ *
+ *****************************************************************************/
+
+#ifndef WMTK_LONG_TERM_MEMORY_H
+#define WMTK_LONG_TERM_MEMORY_H
+
+#include <vector>
+
+#include <Chunk.h>
+
+using namespace std;
+
+class FeatureVector;
+class NumericArena;
+
+class LongTermMemory {
+
+ public:
+
+  // Constructor
+  LongTermMemory();
+
+  // Constructor
+  // Creates an empty store for chunks with feature vectors of the
+  // specified size.
+  LongTermMemory(int feature_vector_size);
+
+  // Copy-Constructor
+  LongTermMemory(const LongTermMemory&);
+
+  // Destructor
+  ~LongTermMemory();
+
+  // Assignment Operator
+  LongTermMemory& operator=(const LongTermMemory&);
+
+  // Exchanges the contents of this store with those of the provided one,
+  // without copying or allocating.
+  void swap(LongTermMemory&);
+
+  // Returns the size of the feature vectors.
+  int getFeatureVectorSize() const;
+
+  // Returns the number of chunks stored.
+  int getNumberOfChunks() const;
+
+  // Stores a copy of the chunk with the given feature vector, which must
+  // have the store's feature vector size. Returns the index of the
+  // stored chunk, or -1 on failure.
+  int storeChunk(const Chunk& chunk, const FeatureVector& features);
+
+  // Retrieves the stored chunk with the given index (an empty chunk if
+  // there is none).
+  Chunk getChunk(int index) const;
+
+  // Returns the feature vector of the stored chunk with the given index
+  // (NULL if there is none).
+  const double* getFeatures(int index) const;
+
+  // Finds the count stored chunks whose feature vectors have the largest
+  // dot products with the cue (a vector of the feature vector size), and
+  // writes their indices, best first, to indices (and their dot products
+  // to scores, unless it is NULL). Among equal dot products, the chunk
+  // stored first comes first. Returns the number of chunks found, which
+  // is less than count if fewer chunks are stored.
+  int retrieve(const double* cue, int count, int* indices,
+	       double* scores = NULL) const;
+
+  // Removes all of the stored chunks.
+  void clear();
+
+ private:
+  int vector_size; // Size of the feature vectors.
+  int capacity; // Number of feature vectors the block has room for.
+  NumericArena* features; // Feature vectors, one after the other.
+  vector<Chunk> chunks; // Stored chunks, in order.
+
+  void init();
+  void dispose();
+  void copy(const LongTermMemory&);
+  bool reserve(int number_of_vectors);
+};
+
+#endif
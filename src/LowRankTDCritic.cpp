@@ -0,0 +1,319 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+/******************************************************************************
+ * LowRankTDCritic.cpp
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * This class is a critic engine for the conjunctive codes of working
+ * memory contents that represents the conjunctive weight tensor as a
+ * sum of rank outer products of per-slot factor vectors.
+ *
+ *****************************************************************************/
+
+#include <LowRankTDCritic.h>
+#include <random_number_generator.h>
+#include <cstddef>
+#include <cmath>
+#include <fstream>
+
+void LowRankTDCritic::init() {
+  s_size = 0;
+  c_size = 0;
+  chunks = 0;
+  o_size = 0;
+  rank = 0;
+  state_conjunct = false;
+  modes = 0;
+  rank_size = 0;
+  parameter_size = 0;
+  parameters = NULL;
+  traces = NULL;
+  dots = NULL;
+}
+
+void LowRankTDCritic::dispose() {
+  storage.release();
+  init();
+}
+
+void LowRankTDCritic::layoutStorage() {
+  parameters = storage.at(0);
+  traces = storage.at(parameter_size);
+  dots = storage.at(2 * parameter_size);
+}
+
+void LowRankTDCritic::copy(const LowRankTDCritic& src) {
+  TDCritic::operator=(src);
+  s_size = src.s_size;
+  c_size = src.c_size;
+  chunks = src.chunks;
+  o_size = src.o_size;
+  rank = src.rank;
+  state_conjunct = src.state_conjunct;
+  modes = src.modes;
+  rank_size = src.rank_size;
+  parameter_size = src.parameter_size;
+  storage = src.storage;
+  if (parameter_size > 0)
+    layoutStorage();
+}
+
+LowRankTDCritic::LowRankTDCritic() : TDCritic() {
+  init();
+}
+
+LowRankTDCritic::LowRankTDCritic(int state_size, int chunk_size, int number_of_chunks, int or_size, int rank_value, bool conjunct_state, double discount_rate, double lambda_value, double learning_rate_value) : TDCritic(discount_rate, lambda_value, learning_rate_value) {
+  init();
+
+  if (state_size < 0 || chunk_size < 1 || number_of_chunks < 1 ||
+      or_size < 0 || rank_value < 1 || (conjunct_state && state_size < 1))
+    return;
+
+  s_size = state_size;
+  c_size = chunk_size;
+  chunks = number_of_chunks;
+  o_size = or_size;
+  rank = rank_value;
+  state_conjunct = conjunct_state;
+  modes = chunks;
+  rank_size = chunks * c_size;
+  parameter_size = o_size + 1;
+  if (state_conjunct) {
+    modes++;
+    rank_size += s_size;
+  }
+  else
+    parameter_size += s_size;
+  parameter_size += rank * rank_size;
+
+  // Allocated zeroed.
+  storage.allocate((2 * parameter_size) + (rank * modes));
+  layoutStorage();
+}
+
+LowRankTDCritic::LowRankTDCritic(const LowRankTDCritic& L) : TDCritic(L) {
+  init();
+  copy(L);
+}
+
+LowRankTDCritic::~LowRankTDCritic() {
+  dispose();
+}
+
+LowRankTDCritic& LowRankTDCritic::operator=(const LowRankTDCritic& Rhs) {
+  if (this != &Rhs) {
+    init();
+    copy(Rhs);
+  }
+  return *this;
+}
+
+TDCritic* LowRankTDCritic::clone() const {
+  return new LowRankTDCritic(*this);
+}
+
+int LowRankTDCritic::getInputSize() const {
+  if (parameter_size == 0)
+    return 0;
+  return s_size + (chunks * c_size) + o_size;
+}
+
+int LowRankTDCritic::getRank() const {
+  return rank;
+}
+
+int LowRankTDCritic::getNumberOfParameters() const {
+  return parameter_size;
+}
+
+int LowRankTDCritic::modeOffset(int mode) const {
+  if (state_conjunct) {
+    if (mode == 0)
+      return 0;
+    mode--;
+  }
+  return s_size + (mode * c_size);
+}
+
+int LowRankTDCritic::modeSize(int mode) const {
+  if (state_conjunct && mode == 0)
+    return s_size;
+  return c_size;
+}
+
+bool LowRankTDCritic::initializeWeights(RandomNumberGenerator& rng) {
+  if (parameters == NULL)
+    return false;
+
+  int x;
+  int linear_size = parameter_size - (rank * rank_size);
+  double value;
+
+  for (x = 0; x < linear_size; x++)
+    parameters[x] = rng.Number();
+
+  // A tensor element is a sum of rank products of modes factor
+  // elements, so each element is drawn and taken to the 1/modes power
+  // of its share of the sum.
+  for (; x < parameter_size; x++) {
+    value = rng.Number();
+    if (value < 0.0)
+      parameters[x] = -pow(-value / rank, 1.0 / modes);
+    else
+      parameters[x] = pow(value / rank, 1.0 / modes);
+  }
+
+  return true;
+}
+
+bool LowRankTDCritic::clearEligibilityTraces() {
+  if (traces == NULL)
+    return false;
+
+  for (int x = 0; x < parameter_size; x++)
+    traces[x] = 0.0;
+
+  return true;
+}
+
+double LowRankTDCritic::evaluate(const double* inputs) const {
+  if (parameters == NULL || inputs == NULL)
+    return 0.0;
+
+  int x, r, m;
+  int size;
+  int linear_size = parameter_size - (rank * rank_size);
+  const double* p = parameters;
+  const double* in;
+  double value = 0.0;
+  double term, dot;
+
+  // Linear part: state (for WM_CONJ), OR vector, and bias.
+  if (!state_conjunct)
+    for (x = 0; x < s_size; x++)
+      value += *(p++) * inputs[x];
+  in = inputs + s_size + (chunks * c_size);
+  for (x = 0; x < o_size; x++)
+    value += *(p++) * in[x];
+  value += *(p++);
+
+  // Conjunctive part: one product of dot products per term.
+  for (r = 0; r < rank; r++) {
+    p = parameters + linear_size + (r * rank_size);
+    term = 1.0;
+    for (m = 0; m < modes && term != 0.0; m++) {
+      in = inputs + modeOffset(m);
+      size = modeSize(m);
+      dot = 0.0;
+      for (x = 0; x < size; x++)
+	dot += p[x] * in[x];
+      term *= dot;
+      p += size;
+    }
+    value += term;
+  }
+
+  return value;
+}
+
+double LowRankTDCritic::tdUpdate(const double* last_inputs, double last_value, const double* next_inputs, double next_value, double reward, bool absorb_reward) {
+  if (parameters == NULL || last_inputs == NULL || next_inputs == NULL)
+    return 0.0;
+
+  computeTDError(last_value, next_value, reward, absorb_reward);
+
+  int x, r, m, i;
+  int size;
+  int linear_size = parameter_size - (rank * rank_size);
+  double decay = gamma * lambda;
+  double step = learning_rate * td_error;
+  double scale;
+  const double* in;
+  double* p;
+
+  // Dot products of every factor vector with the last inputs.
+  p = parameters + linear_size;
+  for (r = 0; r < rank; r++)
+    for (m = 0; m < modes; m++) {
+      in = last_inputs + modeOffset(m);
+      size = modeSize(m);
+      dots[(r * modes) + m] = 0.0;
+      for (x = 0; x < size; x++)
+	dots[(r * modes) + m] += p[x] * in[x];
+      p += size;
+    }
+
+  // Linear part: the gradient is the input itself.
+  i = 0;
+  if (!state_conjunct)
+    for (x = 0; x < s_size; x++, i++) {
+      traces[i] = (decay * traces[i]) + last_inputs[x];
+      parameters[i] += step * traces[i];
+    }
+  in = last_inputs + s_size + (chunks * c_size);
+  for (x = 0; x < o_size; x++, i++) {
+    traces[i] = (decay * traces[i]) + in[x];
+    parameters[i] += step * traces[i];
+  }
+  traces[i] = (decay * traces[i]) + 1.0;
+  parameters[i] += step * traces[i];
+  i++;
+
+  // Factor vectors: the gradient is the product of the term's other dot
+  // products times the factor's input vector.
+  for (r = 0; r < rank; r++)
+    for (m = 0; m < modes; m++) {
+      scale = 1.0;
+      for (x = 0; x < modes; x++)
+	if (x != m)
+	  scale *= dots[(r * modes) + x];
+      in = last_inputs + modeOffset(m);
+      size = modeSize(m);
+      for (x = 0; x < size; x++, i++) {
+	traces[i] = (decay * traces[i]) + (scale * in[x]);
+	parameters[i] += step * traces[i];
+      }
+    }
+
+  return evaluate(next_inputs);
+}
+
+bool LowRankTDCritic::writeWeights(ofstream& file_stream) {
+  if (parameters == NULL)
+    return false;
+
+  for (int x = 0; x < parameter_size; x++)
+    file_stream << parameters[x] << " " << endl;
+
+  return true;
+}
+
+bool LowRankTDCritic::readWeights(ifstream& file_stream) {
+  if (parameters == NULL)
+    return false;
+
+  for (int x = 0; x < parameter_size; x++)
+    file_stream >> parameters[x];
+
+  return true;
+}
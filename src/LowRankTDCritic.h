@@ -0,0 +1,163 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+/******************************************************************************
+ * LowRankTDCritic.h
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * This class is a critic engine for the conjunctive codes of working
+ * memory contents (WM_CONJ, or COMPLETE_CONJ when the state is part of
+ * the conjunction). Rather than keeping one weight per element of the
+ * product of the chunk vectors, the weight tensor is represented as a
+ * sum of rank outer products (a CP decomposition) with one factor
+ * vector per chunk slot (and per state, for COMPLETE_CONJ):
+ *
+ *   T = sum over r of  u[r][0] (x) u[r][1] (x) ... (x) u[r][k-1]
+ *
+ * The value of a conjunctive code is then the sum over r of the
+ * products of the dot products of each factor vector with its chunk
+ * vector, costing O(rank * k * c) rather than O(c^k), and the
+ * parameters take rank * k * c values instead of c^k.
+ *
+ * The input vectors are the factors of the code laid out one after the
+ * other (the layout of the CONCAT code): the state vector, each chunk
+ * slot's vector, and the OR vector. The state (for WM_CONJ) and the OR
+ * vector get ordinary linear weights, and there is a bias weight.
+ *
+ *****************************************************************************/
+
+#ifndef WMTK_LOW_RANK_TD_CRITIC_H
+#define WMTK_LOW_RANK_TD_CRITIC_H
+
+#include <TDCritic.h>
+#include <numeric_arena.h>
+#include <fstream>
+
+using namespace std;
+
+class RandomNumberGenerator;
+
+class LowRankTDCritic : public TDCritic {
+
+ public:
+
+  // Constructor
+  LowRankTDCritic();
+
+  // Constructor
+  // Creates a critic of the specified rank for the conjunction of
+  // number_of_chunks chunk vectors of size chunk_size. The state vector
+  // is part of the conjunction if conjunct_state is set (COMPLETE_CONJ)
+  // and is weighted linearly otherwise (WM_CONJ). The OR vector is
+  // or_size long.
+  LowRankTDCritic(int state_size,
+		  int chunk_size,
+		  int number_of_chunks,
+		  int or_size,
+		  int rank,
+		  bool conjunct_state,
+		  double discount_rate,
+		  double lambda_value,
+		  double learning_rate_value);
+
+  // Copy-Constructor
+  LowRankTDCritic(const LowRankTDCritic&);
+
+  // Destructor
+  ~LowRankTDCritic();
+
+  // Assignment Operator
+  LowRankTDCritic& operator=(const LowRankTDCritic&);
+
+  // Returns a newly allocated copy of this critic.
+  TDCritic* clone() const;
+
+  // Returns the size of the input vectors.
+  int getInputSize() const;
+
+  // Returns the rank of the weight tensor.
+  int getRank() const;
+
+  // Returns the number of parameters.
+  int getNumberOfParameters() const;
+
+  // Draws the linear weights from the provided RandomNumberGenerator.
+  // Each factor element is drawn as well and scaled so that each element
+  // of the weight tensor starts out on the order of a single draw (as
+  // the weights of the dense conjunctive critic do). Draws centered on
+  // zero leave every factor near zero, where the gradient of each
+  // product vanishes, so learning starts slowly from such a draw.
+  bool initializeWeights(RandomNumberGenerator& rng);
+
+  // Clears the eligibility traces.
+  bool clearEligibilityTraces();
+
+  // Returns the value of the provided input vector.
+  double evaluate(const double* inputs) const;
+
+  // Performs one TD(lambda) step using the gradient of the factored
+  // value with respect to every factor vector (the other factors' dot
+  // products times the factor's own input vector). Returns the value of
+  // next_inputs under the updated parameters.
+  double tdUpdate(const double* last_inputs,
+		  double last_value,
+		  const double* next_inputs,
+		  double next_value,
+		  double reward,
+		  bool absorb_reward);
+
+  // Writes/reads the parameters, one per line, in storage order.
+  bool writeWeights(ofstream& file_stream);
+  bool readWeights(ifstream& file_stream);
+
+ private:
+  int s_size; // Size of the state vector.
+  int c_size; // Size of each chunk vector.
+  int chunks; // Number of chunk slots.
+  int o_size; // Size of the OR vector.
+  int rank; // Number of terms in the decomposition.
+  bool state_conjunct; // Whether the state is a mode of the tensor.
+  int modes; // Number of modes of the tensor.
+  int rank_size; // Parameters per term of the decomposition.
+  int parameter_size; // Total number of parameters.
+
+  // Storage holds the parameters (state weights, OR weights, bias, then
+  // the factor vectors of each term, state factor first), the traces in
+  // the same layout, and work space for the per-term dot products.
+  NumericArena storage;
+  double* parameters;
+  double* traces;
+  double* dots;
+
+  // Returns the offset of the input vector for a mode.
+  int modeOffset(int mode) const;
+
+  // Returns the size of the input vector for a mode.
+  int modeSize(int mode) const;
+
+  void init();
+  void dispose();
+  void copy(const LowRankTDCritic&);
+  void layoutStorage();
+};
+
+#endif
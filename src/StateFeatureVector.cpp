@@ -37,15 +37,23 @@
  *****************************************************************************/
 
 #include <StateFeatureVector.h>
+#include <feature_kernels.h>
 #include <cstddef>
+#include <algorithm>
 
 StateFeatureVector::StateFeatureVector() : FeatureVector() {
   translate = NULL; // Empty function
+  base_revision = 0;
+  ranges_revision = 0;
+  detect_changes = false;
   return;
 }
 
 StateFeatureVector::StateFeatureVector(int vector_size, void (*translation_function)(FeatureVector&, WorkingMemory&)) : FeatureVector(vector_size) {
   translate = NULL;
+  base_revision = 0;
+  ranges_revision = 0;
+  detect_changes = false;
 
   if (translation_function != NULL) // If provided with a function, use it
     translate = translation_function;
@@ -55,7 +63,11 @@ StateFeatureVector::StateFeatureVector(int vector_size, void (*translation_funct
 
 StateFeatureVector::StateFeatureVector(const StateFeatureVector& L) : FeatureVector(L) {
   translate = NULL;
-  FeatureVector::operator=(L); // Use parent assignment
+  changed_ranges = L.changed_ranges;
+  base_revision = L.base_revision;
+  ranges_revision = L.ranges_revision;
+  detect_changes = L.detect_changes;
+  previous = L.previous;
 
   if (L.translate != NULL) // If it has a function, use it
     translate = L.translate;
@@ -71,10 +83,41 @@ StateFeatureVector& StateFeatureVector::operator=(const StateFeatureVector& Rhs)
 
     if (Rhs.translate != NULL) // Again, if it has a function, use it
       translate = Rhs.translate;
+
+    changed_ranges = Rhs.changed_ranges;
+    base_revision = Rhs.base_revision;
+    ranges_revision = Rhs.ranges_revision;
+    detect_changes = Rhs.detect_changes;
+    previous = Rhs.previous;
   }
   return *this;
 }
 
+void StateFeatureVector::swap(StateFeatureVector& other) {
+  FeatureVector::swap(other);
+  std::swap(translate, other.translate);
+  changed_ranges.swap(other.changed_ranges);
+  std::swap(base_revision, other.base_revision);
+  std::swap(ranges_revision, other.ranges_revision);
+  std::swap(detect_changes, other.detect_changes);
+  previous.swap(other.previous);
+}
+
+#if __cplusplus >= 201103L
+StateFeatureVector::StateFeatureVector(StateFeatureVector&& L) noexcept : FeatureVector() {
+  translate = NULL;
+  base_revision = 0;
+  ranges_revision = 0;
+  detect_changes = false;
+  swap(L);
+}
+
+StateFeatureVector& StateFeatureVector::operator=(StateFeatureVector&& Rhs) noexcept {
+  swap(Rhs);
+  return *this;
+}
+#endif
+
 StateFeatureVector::~StateFeatureVector() {
   translate = NULL; // This may not be needed, but you never know...
 }
@@ -83,10 +126,94 @@ bool StateFeatureVector::updateFeatures(WorkingMemory& wm) {
   if (translate == NULL)
     return false;	// If we don't have a function, this is a problem
 
+  int x, y;
+
+  base_revision = getRevision();
+  changed_ranges.clear();
   translate(*this, wm);
+
+  if (!changed_ranges.empty()) {
+    // Only the marked ranges were written
+    double* values = getWritableValues();
+    int ranges = changed_ranges.size();
+    for (x = 0; x < ranges; x += 2)
+      ::clampValues(values + changed_ranges[x], changed_ranges[x + 1],
+		    WMTK_FV_MIN, WMTK_FV_MAX);
+    if (detect_changes)
+      for (x = 0; x < ranges; x += 2)
+	copyValues(&previous[changed_ranges[x]], values + changed_ranges[x],
+		   changed_ranges[x + 1]);
+    ranges_revision = getRevision();
+  }
+  else if (getRevision() == base_revision) {
+    // Nothing was written
+    ranges_revision = getRevision();
+  }
+  else {
+    clampValues();	// In case of bulk writes (see getWritableValues)
+    ranges_revision = 0;
+    if (detect_changes) {
+      // Gather the elements that differ from the previous contents into
+      // ranges
+      const double* values = getValues();
+      for (x = 0; x < getSize(); x = y) {
+	if (values[x] == previous[x]) {
+	  y = x + 1;
+	  continue;
+	}
+	for (y = x + 1; y < getSize() && values[y] != previous[y]; y++)
+	  ;
+	changed_ranges.push_back(x);
+	changed_ranges.push_back(y - x);
+	copyValues(&previous[x], values + x, y - x);
+      }
+      ranges_revision = getRevision();
+    }
+  }
+
+  return true;
+}
+
+bool StateFeatureVector::markChanged(int first, int count) {
+  if (first < 0 || count < 0 || first > getSize() - count)
+    return false;
+
+  if (count > 0) {
+    changed_ranges.push_back(first);
+    changed_ranges.push_back(count);
+  }
+  return true;
+}
+
+bool StateFeatureVector::setChangeDetection(bool detect) {
+  detect_changes = detect;
+  if (detect_changes)
+    previous.assign(getValues(), getValues() + getSize());
+  else
+    previous.clear();
+  return true;
+}
+
+int StateFeatureVector::getNumberOfChangedRanges() const {
+  if (ranges_revision == 0 || ranges_revision != getRevision())
+    return -1;
+
+  return changed_ranges.size() / 2;
+}
+
+bool StateFeatureVector::getChangedRange(int index, int& first, int& count) const {
+  if (index < 0 || index >= getNumberOfChangedRanges())
+    return false;
+
+  first = changed_ranges[2 * index];
+  count = changed_ranges[(2 * index) + 1];
   return true;
 }
 
+unsigned long StateFeatureVector::getBaseRevision() const {
+  return base_revision;
+}
+
 bool StateFeatureVector::setTranslationFunction(void (*translation_function)
 						(FeatureVector&,
 						 WorkingMemory&)) {
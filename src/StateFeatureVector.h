@@ -31,6 +31,13 @@
  * JLP - 5/4/04 9:04PM
  *		First draft version.
  *
+ * The vector can also report the ranges of elements that its last update
+ * changed, so that consumers holding a copy of the previous contents
+ * (see AggregateFeatureVector::setFactors) need only refresh those. The
+ * ranges are either marked by the translation function (see
+ * markChanged) or found by comparing the contents with a copy of the
+ * previous ones (see setChangeDetection).
+ *
  *****************************************************************************/
 
 #ifndef WMTK_STATE_FEATURE_VECTOR_H
@@ -38,8 +45,11 @@
 
 class WorkingMemory;
 
+#include <vector>
 #include <FeatureVector.h>
 
+using namespace std;
+
 class StateFeatureVector : public FeatureVector {
 
  public:
@@ -60,15 +70,53 @@ class StateFeatureVector : public FeatureVector {
 
   // Assignment Operator
   StateFeatureVector& operator=(const StateFeatureVector&);
+
+  // Exchanges the contents of this vector with those of the provided
+  // one, without copying or allocating.
+  void swap(StateFeatureVector&);
+
+#if __cplusplus >= 201103L
+  // Move-Constructor and Move-Assignment
+  // Take over the contents of the source, which is left valid but
+  // unspecified.
+  StateFeatureVector(StateFeatureVector&&) noexcept;
+  StateFeatureVector& operator=(StateFeatureVector&&) noexcept;
+#endif
 		
   // Destructor
   ~StateFeatureVector();
 
   // Calls the translation function to map the information about the
-  // current state into the vector. Returns true if successful, and
-  // false otherwise.
+  // current state into the vector, then limits the elements to the
+  // valid range (the function may fill getWritableValues() directly).
+  // If the function marks the ranges it changed (see markChanged), only
+  // those are limited. Returns true if successful, and false otherwise.
   bool	updateFeatures(WorkingMemory& wm);
 
+  // Records that count elements from first were changed by the
+  // translation function during the current update, which leaves the
+  // rest of the vector as it was (so the function must not clear the
+  // vector). Returns false if the range does not fit.
+  bool	markChanged(int first, int count);
+
+  // Turns on or off the detection of the changed ranges by comparing
+  // the contents after each update with a copy of those before it, for
+  // translation functions that do not mark their changes. Returns true.
+  bool	setChangeDetection(bool detect);
+
+  // Returns the number of ranges of elements changed by the last update,
+  // or -1 if they are not known (the function did not mark them and
+  // they are not detected) or the vector has changed since.
+  int	getNumberOfChangedRanges() const;
+
+  // Retrieves the first element and length of the changed range with the
+  // given index. Returns false if there is no such range.
+  bool	getChangedRange(int index, int& first, int& count) const;
+
+  // Returns the revision (see FeatureVector::getRevision) of the contents
+  // before the last update, to which the changed ranges are relative.
+  unsigned long getBaseRevision() const;
+
   // Sets the translation function to the one provided as an argument.
   // Returns true on success and false otherwise.
   bool    setTranslationFunction(void (*translation_function)
@@ -76,6 +124,12 @@ class StateFeatureVector : public FeatureVector {
 
  private:
   void (*translate)(FeatureVector&, WorkingMemory&);
+  vector<int> changed_ranges; // First element and length of each range.
+  unsigned long base_revision; // Revision before the last update.
+  unsigned long ranges_revision; // Revision after it (0 if the ranges
+  // are not known).
+  bool detect_changes; // Whether the changes are found by comparison,
+  vector<double> previous; // against these contents.
 };
 
 #endif
@@ -0,0 +1,112 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+/******************************************************************************
+ * TDCritic.cpp
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * This is the base class for the specialized critic engines used by the
+ * CriticNetwork class.
+ *
+ *****************************************************************************/
+
+#include <TDCritic.h>
+#include <cstddef>
+
+TDCritic::TDCritic() {
+  gamma = 1.0;
+  lambda = 0.0;
+  learning_rate = 0.0;
+  td_error = 0.0;
+}
+
+TDCritic::TDCritic(double discount_rate, double lambda_value, double learning_rate_value) {
+  gamma = discount_rate;
+  lambda = lambda_value;
+  if (lambda_value < 0.0 || lambda_value > 1.0)
+    lambda = 0.0;
+  learning_rate = learning_rate_value;
+  td_error = 0.0;
+}
+
+TDCritic::~TDCritic() {
+}
+
+void TDCritic::evaluateBatch(int count, const double* const* inputs, double* values) const {
+  if (inputs == NULL || values == NULL)
+    return;
+
+  for (int y = 0; y < count; y++)
+    values[y] = evaluate(inputs[y]);
+}
+
+double TDCritic::evaluateSparse(const double* inputs, const int*, int) const {
+  return evaluate(inputs);
+}
+
+double TDCritic::tdUpdateSparse(const double* last_inputs, const int*, int, double last_value, const double* next_inputs, double next_value, double reward, bool absorb_reward) {
+  return tdUpdate(last_inputs, last_value, next_inputs, next_value, reward,
+		  absorb_reward);
+}
+
+double TDCritic::computeTDError(double last_value, double next_value, double reward, bool absorb_reward) {
+  if (absorb_reward)
+    td_error = reward - last_value;
+  else
+    td_error = reward + (gamma * next_value) - last_value;
+
+  return td_error;
+}
+
+double TDCritic::getTDError() const {
+  return td_error;
+}
+
+double TDCritic::getLearningRate() const {
+  return learning_rate;
+}
+
+bool TDCritic::setLearningRate(double value) {
+  learning_rate = value;
+  return true;
+}
+
+double TDCritic::getGamma() const {
+  return gamma;
+}
+
+bool TDCritic::setGamma(double value) {
+  gamma = value;
+  return true;
+}
+
+double TDCritic::getLambda() const {
+  return lambda;
+}
+
+bool TDCritic::setLambda(double value) {
+  if (value < 0.0 || value > 1.0)
+    return false;
+
+  lambda = value;
+  return true;
+}
@@ -0,0 +1,136 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+/******************************************************************************
+ * TDCritic.h
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * This is the base class for the specialized critic engines used by the
+ * CriticNetwork class (such as the LinearTDCritic). Each engine maps an
+ * input vector to a value and learns by TD(lambda) with eligibility
+ * traces over its own parameters; this class holds the learning
+ * parameters they have in common.
+ *
+ *****************************************************************************/
+
+#ifndef WMTK_TD_CRITIC_H
+#define WMTK_TD_CRITIC_H
+
+#include <fstream>
+
+using namespace std;
+
+class RandomNumberGenerator;
+
+class TDCritic {
+
+ public:
+
+  // Constructor
+  TDCritic();
+
+  // Constructor
+  TDCritic(double discount_rate,
+	   double lambda_value,
+	   double learning_rate_value);
+
+  // Destructor
+  virtual ~TDCritic();
+
+  // Returns a newly allocated copy of this critic.
+  virtual TDCritic* clone() const = 0;
+
+  // Returns the size of the input vectors.
+  virtual int getInputSize() const = 0;
+
+  // Draws the parameters from the provided RandomNumberGenerator.
+  virtual bool initializeWeights(RandomNumberGenerator& rng) = 0;
+
+  // Clears the eligibility traces.
+  virtual bool clearEligibilityTraces() = 0;
+
+  // Returns the value of the provided input vector.
+  virtual double evaluate(const double* inputs) const = 0;
+
+  // Computes the values of several input vectors at once.
+  virtual void evaluateBatch(int count, const double* const* inputs,
+			     double* values) const;
+
+  // Returns the value of an input vector whose nonzero elements are at
+  // the count positions listed (in increasing order) in nonzero. By
+  // default this is evaluate(inputs).
+  virtual double evaluateSparse(const double* inputs,
+				const int* nonzero,
+				int count) const;
+
+  // Performs one TD(lambda) step for the transition from last_inputs
+  // (whose value was last_value) to next_inputs (whose value is
+  // next_value). When absorb_reward is set, the transition is into a
+  // terminal state and next_value is ignored for the TD error. Returns
+  // the value of next_inputs under the updated parameters.
+  virtual double tdUpdate(const double* last_inputs,
+			  double last_value,
+			  const double* next_inputs,
+			  double next_value,
+			  double reward,
+			  bool absorb_reward) = 0;
+
+  // Performs the same step as tdUpdate when the nonzero elements of
+  // last_inputs are at the last_count positions listed (in increasing
+  // order) in last_nonzero. By default this is tdUpdate.
+  virtual double tdUpdateSparse(const double* last_inputs,
+				const int* last_nonzero,
+				int last_count,
+				double last_value,
+				const double* next_inputs,
+				double next_value,
+				double reward,
+				bool absorb_reward);
+
+  // Writes/reads the parameters, one value per line.
+  virtual bool writeWeights(ofstream& file_stream) = 0;
+  virtual bool readWeights(ifstream& file_stream) = 0;
+
+  // Returns the TD error computed by the last tdUpdate call.
+  double getTDError() const;
+
+  double getLearningRate() const;
+  bool setLearningRate(double value);
+
+  double getGamma() const;
+  bool setGamma(double value);
+
+  double getLambda() const;
+  bool setLambda(double value);
+
+ protected:
+  double gamma; // Reward discount rate.
+  double lambda; // Eligibility trace discount rate.
+  double learning_rate; // Learning rate.
+  double td_error; // TD error from the last update.
+
+  // Computes (and remembers) the TD error of a transition.
+  double computeTDError(double last_value, double next_value,
+			double reward, bool absorb_reward);
+};
+
+#endif
@@ -0,0 +1,378 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+/******************************************************************************
+ * TiedTDCritic.cpp
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * This class is a critic engine for the CONCAT code in which the chunk
+ * slots share their weights.
+ *
+ *****************************************************************************/
+
+#include <TiedTDCritic.h>
+#include <random_number_generator.h>
+#include <cstddef>
+#include <fstream>
+
+void TiedTDCritic::init() {
+  s_size = 0;
+  c_size = 0;
+  chunks = 0;
+  o_size = 0;
+  pairs = false;
+  parameter_size = 0;
+  parameters = NULL;
+  traces = NULL;
+  chunk_sum = NULL;
+}
+
+void TiedTDCritic::dispose() {
+  storage.release();
+  init();
+}
+
+void TiedTDCritic::layoutStorage() {
+  parameters = storage.at(0);
+  traces = storage.at(parameter_size);
+  chunk_sum = storage.at(2 * parameter_size);
+}
+
+void TiedTDCritic::copy(const TiedTDCritic& src) {
+  TDCritic::operator=(src);
+  s_size = src.s_size;
+  c_size = src.c_size;
+  chunks = src.chunks;
+  o_size = src.o_size;
+  pairs = src.pairs;
+  parameter_size = src.parameter_size;
+  storage = src.storage;
+  if (parameter_size > 0)
+    layoutStorage();
+}
+
+TiedTDCritic::TiedTDCritic() : TDCritic() {
+  init();
+}
+
+TiedTDCritic::TiedTDCritic(int state_size, int chunk_size, int number_of_chunks, int or_size, bool use_pairs, double discount_rate, double lambda_value, double learning_rate_value) : TDCritic(discount_rate, lambda_value, learning_rate_value) {
+  init();
+
+  if (state_size < 0 || chunk_size < 1 || number_of_chunks < 1 ||
+      or_size < 0)
+    return;
+
+  s_size = state_size;
+  c_size = chunk_size;
+  chunks = number_of_chunks;
+  o_size = or_size;
+  pairs = use_pairs;
+  parameter_size = s_size + c_size + o_size + 1;
+  if (pairs)
+    parameter_size += c_size * c_size;
+
+  // Allocated zeroed.
+  storage.allocate((2 * parameter_size) + c_size);
+  layoutStorage();
+}
+
+TiedTDCritic::TiedTDCritic(const TiedTDCritic& L) : TDCritic(L) {
+  init();
+  copy(L);
+}
+
+TiedTDCritic::~TiedTDCritic() {
+  dispose();
+}
+
+TiedTDCritic& TiedTDCritic::operator=(const TiedTDCritic& Rhs) {
+  if (this != &Rhs) {
+    dispose();
+    copy(Rhs);
+  }
+  return *this;
+}
+
+TDCritic* TiedTDCritic::clone() const {
+  return new TiedTDCritic(*this);
+}
+
+int TiedTDCritic::getInputSize() const {
+  if (parameter_size == 0)
+    return 0;
+  return s_size + (chunks * c_size) + o_size;
+}
+
+int TiedTDCritic::getNumberOfParameters() const {
+  return parameter_size;
+}
+
+int TiedTDCritic::getStateSize() const {
+  return s_size;
+}
+
+int TiedTDCritic::getChunkSize() const {
+  return c_size;
+}
+
+bool TiedTDCritic::hasPairs() const {
+  return pairs;
+}
+
+bool TiedTDCritic::initializeWeights(RandomNumberGenerator& rng) {
+  if (parameters == NULL)
+    return false;
+
+  int x;
+  int linear_size = s_size + c_size + o_size + 1;
+
+  for (x = 0; x < linear_size; x++)
+    parameters[x] = rng.Number();
+  for (; x < parameter_size; x++)
+    parameters[x] = 0.0;
+
+  return true;
+}
+
+bool TiedTDCritic::clearEligibilityTraces() {
+  if (traces == NULL)
+    return false;
+
+  for (int x = 0; x < parameter_size; x++)
+    traces[x] = 0.0;
+
+  return true;
+}
+
+double TiedTDCritic::chunkScore(const double* chunk) const {
+  if (parameters == NULL || chunk == NULL)
+    return 0.0;
+
+  const double* w = parameters + s_size;
+  double value = 0.0;
+
+  for (int x = 0; x < c_size; x++)
+    value += w[x] * chunk[x];
+
+  return value;
+}
+
+double TiedTDCritic::pairScore(const double* first, const double* second) const {
+  if (!pairs || parameters == NULL || first == NULL || second == NULL)
+    return 0.0;
+
+  const double* p = parameters + s_size + c_size + o_size + 1;
+  double value = 0.0;
+  double row;
+  int x, y;
+
+  for (x = 0; x < c_size; x++, p += c_size) {
+    if (first[x] == 0.0)
+      continue;
+    row = 0.0;
+    for (y = 0; y < c_size; y++)
+      row += p[y] * second[y];
+    value += first[x] * row;
+  }
+
+  return value;
+}
+
+double TiedTDCritic::contextScore(const double* state, const double* or_values) const {
+  if (parameters == NULL || state == NULL || or_values == NULL)
+    return 0.0;
+
+  const double* w = parameters;
+  double value = 0.0;
+  int x;
+
+  for (x = 0; x < s_size; x++)
+    value += w[x] * state[x];
+  w += s_size + c_size;
+  for (x = 0; x < o_size; x++)
+    value += w[x] * or_values[x];
+
+  return value + w[o_size];
+}
+
+void TiedTDCritic::pairScores(int count, const double* const* chunk_values, double* scores) const {
+  int x, y, z;
+
+  if (!pairs || parameters == NULL) {
+    for (x = 0; x < count * count; x++)
+      scores[x] = 0.0;
+    return;
+  }
+
+  const double* p = parameters + s_size + c_size + o_size + 1;
+  const double* row;
+  const double* b;
+  double* products = new double[count * c_size];
+  double* pb;
+  double value;
+
+  // products holds P times each chunk vector, one after the other.
+  for (y = 0, pb = products; y < count; y++, pb += c_size) {
+    b = chunk_values[y];
+    for (x = 0, row = p; x < c_size; x++, row += c_size) {
+      value = 0.0;
+      for (z = 0; z < c_size; z++)
+	value += row[z] * b[z];
+      pb[x] = value;
+    }
+  }
+
+  for (x = 0; x < count; x++)
+    for (y = 0, pb = products; y < count; y++, pb += c_size) {
+      value = 0.0;
+      for (z = 0; z < c_size; z++)
+	value += chunk_values[x][z] * pb[z];
+      scores[(x * count) + y] = value;
+    }
+
+  delete [] products;
+}
+
+// Returns the pair terms of the chunk vectors laid out one after the
+// other, leaving their sum in sum.
+double TiedTDCritic::pairValue(const double* chunk_values, double* sum) const {
+  int x, y;
+  const double* c;
+  double value;
+
+  for (y = 0; y < c_size; y++)
+    sum[y] = 0.0;
+  for (x = 0, c = chunk_values; x < chunks; x++, c += c_size)
+    for (y = 0; y < c_size; y++)
+      sum[y] += c[y];
+
+  if (!pairs)
+    return 0.0;
+
+  value = pairScore(sum, sum);
+  for (x = 0, c = chunk_values; x < chunks; x++, c += c_size)
+    value -= pairScore(c, c);
+
+  return 0.5 * value;
+}
+
+double TiedTDCritic::evaluate(const double* inputs) const {
+  if (parameters == NULL || inputs == NULL)
+    return 0.0;
+
+  // A const evaluation keeps its sum to itself rather than in chunk_sum.
+  const double* chunk_values = inputs + s_size;
+  double* sum = new double[c_size];
+  double value = pairValue(chunk_values, sum);
+
+  value += chunkScore(sum);
+  value += contextScore(inputs, chunk_values + (chunks * c_size));
+
+  delete [] sum;
+  return value;
+}
+
+double TiedTDCritic::tdUpdate(const double* last_inputs, double last_value, const double* next_inputs, double next_value, double reward, bool absorb_reward) {
+  if (parameters == NULL || last_inputs == NULL || next_inputs == NULL)
+    return 0.0;
+
+  computeTDError(last_value, next_value, reward, absorb_reward);
+
+  int x, y, i;
+  double decay = gamma * lambda;
+  double step = learning_rate * td_error;
+  const double* chunk_values = last_inputs + s_size;
+  const double* or_values = chunk_values + (chunks * c_size);
+  const double* c;
+  double* t;
+
+  pairValue(chunk_values, chunk_sum);
+
+  // Linear part: the chunk weights' gradient is the sum of the chunks.
+  i = 0;
+  for (x = 0; x < s_size; x++, i++)
+    traces[i] = (decay * traces[i]) + last_inputs[x];
+  for (x = 0; x < c_size; x++, i++)
+    traces[i] = (decay * traces[i]) + chunk_sum[x];
+  for (x = 0; x < o_size; x++, i++)
+    traces[i] = (decay * traces[i]) + or_values[x];
+  traces[i] = (decay * traces[i]) + 1.0;
+  i++;
+
+  // Pair weights: the gradient is (S S' - sum over i of c_i c_i') / 2,
+  // which is symmetric, so P stays symmetric.
+  if (pairs) {
+    t = traces + i;
+    for (x = 0; x < c_size; x++)
+      for (y = 0; y < c_size; y++)
+	t[(x * c_size) + y] = (decay * t[(x * c_size) + y]) +
+	  (0.5 * chunk_sum[x] * chunk_sum[y]);
+    for (i = 0, c = chunk_values; i < chunks; i++, c += c_size)
+      for (x = 0; x < c_size; x++) {
+	if (c[x] == 0.0)
+	  continue;
+	for (y = 0; y < c_size; y++)
+	  t[(x * c_size) + y] -= 0.5 * c[x] * c[y];
+      }
+  }
+
+  for (x = 0; x < parameter_size; x++)
+    parameters[x] += step * traces[x];
+
+  return evaluate(next_inputs);
+}
+
+bool TiedTDCritic::writeWeights(ofstream& file_stream) {
+  if (parameters == NULL)
+    return false;
+
+  for (int x = 0; x < parameter_size; x++)
+    file_stream << parameters[x] << " " << endl;
+
+  return true;
+}
+
+bool TiedTDCritic::readWeights(ifstream& file_stream) {
+  if (parameters == NULL)
+    return false;
+
+  int x, y;
+
+  for (x = 0; x < parameter_size; x++)
+    file_stream >> parameters[x];
+
+  // The updates keep P symmetric, which the pair scores of single
+  // candidates assume, so other pair weights are read as (P + P') / 2.
+  if (pairs) {
+    double* p = parameters + s_size + c_size + o_size + 1;
+    double value;
+    for (x = 0; x < c_size; x++)
+      for (y = x + 1; y < c_size; y++) {
+	value = 0.5 * (p[(x * c_size) + y] + p[(y * c_size) + x]);
+	p[(x * c_size) + y] = value;
+	p[(y * c_size) + x] = value;
+      }
+  }
+
+  return true;
+}
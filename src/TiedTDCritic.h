@@ -0,0 +1,166 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+/******************************************************************************
+ * TiedTDCritic.h
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * This class is a critic engine for the CONCAT code of working memory
+ * contents in which every chunk slot shares one block of chunk weights,
+ * so a chunk has the same value in whichever slot it is held and the
+ * value of the contents does not depend on their order. A chunk's value
+ * is learned once rather than once per slot.
+ *
+ * Optionally, every pair of slots also shares one matrix P of pairwise
+ * weights, adding the sum over the pairs of slots i < j of c_i' P c_j to
+ * the value. P is kept symmetric, so the pair terms do not depend on the
+ * order either, and with S the sum of the chunk vectors they come to
+ * (S' P S - sum over i of c_i' P c_i) / 2.
+ *
+ * The value of the contents is thus a sum of terms that each involve one
+ * or two chunks (and a term for the state and the OR vector), and the
+ * chunkScore, pairScore and contextScore functions return those terms
+ * separately, so that a search over the contents can score each
+ * candidate chunk (and pair of candidates) once and add up the scores.
+ *
+ * All of the numeric state sits in a single NumericArena: the state,
+ * chunk and OR weights, the bias weight and the pair weights, then the
+ * traces in the same order, then room for the sum of the chunk vectors.
+ *
+ *****************************************************************************/
+
+#ifndef WMTK_TIED_TD_CRITIC_H
+#define WMTK_TIED_TD_CRITIC_H
+
+#include <TDCritic.h>
+#include <numeric_arena.h>
+#include <fstream>
+
+using namespace std;
+
+class RandomNumberGenerator;
+
+class TiedTDCritic : public TDCritic {
+
+ public:
+
+  // Constructor
+  TiedTDCritic();
+
+  // Constructor
+  // Creates a critic for the CONCAT code of a state vector of size
+  // state_size, number_of_chunks chunk vectors of size chunk_size and an
+  // OR vector of size or_size. The slots share pair weights as well if
+  // use_pairs is set.
+  TiedTDCritic(int state_size,
+	       int chunk_size,
+	       int number_of_chunks,
+	       int or_size,
+	       bool use_pairs,
+	       double discount_rate,
+	       double lambda_value,
+	       double learning_rate_value);
+
+  // Copy-Constructor
+  TiedTDCritic(const TiedTDCritic&);
+
+  // Destructor
+  ~TiedTDCritic();
+
+  // Assignment Operator
+  TiedTDCritic& operator=(const TiedTDCritic&);
+
+  // Returns a newly allocated copy of this critic.
+  TDCritic* clone() const;
+
+  // Returns the size of the input vectors.
+  int getInputSize() const;
+
+  // Returns the number of parameters.
+  int getNumberOfParameters() const;
+
+  // Returns the sizes of the state vector and of each chunk vector.
+  int getStateSize() const;
+  int getChunkSize() const;
+
+  // Returns whether the slots share pair weights.
+  bool hasPairs() const;
+
+  // Draws the state, chunk and OR weights and the bias weight from the
+  // provided RandomNumberGenerator. The pair weights start at zero.
+  bool initializeWeights(RandomNumberGenerator& rng);
+
+  // Clears the eligibility traces.
+  bool clearEligibilityTraces();
+
+  // Returns the value of the provided input vector.
+  double evaluate(const double* inputs) const;
+
+  // Returns the terms of the value: that of one chunk vector (in any
+  // slot), that of a pair of chunk vectors in two different slots (zero
+  // without pair weights), and that of the state and OR vectors
+  // (including the bias).
+  double chunkScore(const double* chunk) const;
+  double pairScore(const double* first, const double* second) const;
+  double contextScore(const double* state, const double* or_values) const;
+
+  // Fills scores with the count by count table of the pair scores of the
+  // given chunk vectors (row major), multiplying each vector by P once.
+  void pairScores(int count, const double* const* chunk_values,
+		  double* scores) const;
+
+  // Performs one TD(lambda) step for the transition from last_inputs to
+  // next_inputs. Returns the value of next_inputs under the updated
+  // parameters.
+  double tdUpdate(const double* last_inputs,
+		  double last_value,
+		  const double* next_inputs,
+		  double next_value,
+		  double reward,
+		  bool absorb_reward);
+
+  // Writes/reads the parameters, one per line, in storage order. The
+  // pair weights read are made symmetric.
+  bool writeWeights(ofstream& file_stream);
+  bool readWeights(ifstream& file_stream);
+
+ private:
+  int s_size; // Size of the state vector.
+  int c_size; // Size of each chunk vector.
+  int chunks; // Number of chunk slots.
+  int o_size; // Size of the OR vector.
+  bool pairs; // Whether the slots share pair weights.
+  int parameter_size; // Number of parameters.
+  NumericArena storage; // Parameters, traces and work space.
+  double* parameters; // State, chunk, OR, bias and pair weights.
+  double* traces; // Eligibility traces, laid out as the parameters.
+  double* chunk_sum; // Sum of the chunk vectors, for tdUpdate only.
+
+  void init();
+  void dispose();
+  void copy(const TiedTDCritic&);
+  void layoutStorage();
+  double pairValue(const double* chunk_values, double* sum) const;
+};
+
+#endif
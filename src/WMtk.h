@@ -38,10 +38,13 @@
 
 #include <ActorNetwork.h>
 #include <AggregateFeatureVector.h>
+#include <BinaryFeatureVector.h>
 #include <ChunkFeatureVector.h>
 #include <Chunk.h>
 #include <CriticNetwork.h>
+#include <FeatureSchema.h>
 #include <FeatureVector.h>
+#include <LongTermMemory.h>
 #include <StateFeatureVector.h>
 #include <WorkingMemory.h>
 
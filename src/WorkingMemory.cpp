@@ -72,6 +72,7 @@
 #include <cstddef>
 #include <cstdlib>
 #include <fstream>
+#include <algorithm>
 #include <list>
 #include <vector>
 #include <uniform_random_number_generator.h>
@@ -80,14 +81,18 @@
 #include <StateFeatureVector.h>
 #include <AggregateFeatureVector.h>
 #include <ActorNetwork.h>
+#include <CandidateScorer.h>
 #include <CriticNetwork.h>
 #include <FeatureVector.h>
 #include <ChunkFeatureVector.h>
+#include <LongTermMemory.h>
 #include <uniform_random_number_generator.h>
 
 //#define OR_ONLY
 //#define USE_SOFTMAX
-#define SM_CONSTANT 5.0;
+// Largest bank for which softmax draws are made by dynamic programming
+// (its table has a column for each set of slots).
+#define SAMPLER_MAX_SLOTS 12
 
 #include <iostream>
 //#define WMTK_DEBUG
@@ -98,12 +103,25 @@ struct WMCombo {
   double value;
 };
 
+// A bank of slots, searched on its own. It takes the candidates of its
+// type (of any type if type is empty) and has its own critic, valuing
+// the state and the contents of its slots.
+struct WMBank {
+  int first_slot;
+  int size;
+  string type;
+  CriticNetwork* critic;
+  AggregateFeatureVector* aggregate;
+  FeatureVector* or_features;
+};
+
 void WorkingMemory::init() {
   state_vector_size = 0;
   chunk_vector_size = 0;
   number_of_chunks = 0;
   number_of_active_chunks = 0;
   working_memory_store = NULL;
+  long_term_slots = NULL;
   chunk_features = NULL;
   state_data_structure = NULL;
   actor_network = NULL;
@@ -116,24 +134,57 @@ void WorkingMemory::init() {
   use_actor = false;
   the_or_code = NO_OR;
   exploration_percentage = MEMORY_EXPLORATION_PERCENTAGE;
+#ifdef USE_SOFTMAX
+  selection_policy = SOFTMAX_SELECTION;
+#else
+  selection_policy = EPSILON_GREEDY_SELECTION;
+#endif
+  selection_gain = MEMORY_SOFTMAX_GAIN;
   last_reward = 0.0;
   or_vector = NULL;
   state_features = NULL;
   aggregate_features = NULL;
+  banks = NULL;
+  number_of_banks = 0;
+  shortlist_size = 0;
+  salience_function = NULL;
+  candidate_scorer = NULL;
+  long_term_memory = NULL;
+  retrieval_count = 0;
+  cue_function = NULL;
+  next_state_features = NULL;
+  change_tolerances.clear();
+  translated_state = NULL;
 
   return;
 }
 
+void WorkingMemory::disposeBanks() {
+  for (int x = 0; x < number_of_banks; x++) {
+    delete banks[x].critic;
+    delete banks[x].aggregate;
+    delete banks[x].or_features;
+  }
+
+  if (banks != NULL)
+    delete [] banks;
+
+  banks = NULL;
+  number_of_banks = 0;
+}
+
 void WorkingMemory::dispose() {
   int x;
 
   if (working_memory_store != NULL) {
     for (x = 0; x < number_of_chunks; x++)
       if (working_memory_store[x] != NULL) {
-	delete_chunk(*working_memory_store[x]);
+	if (!long_term_slots[x])
+	  delete_chunk(*working_memory_store[x]);
 	delete working_memory_store[x];
       }
     delete [] working_memory_store;
+    delete [] long_term_slots;
   }
 
   if (chunk_features != NULL)
@@ -150,10 +201,17 @@ void WorkingMemory::dispose() {
 
   if (state_features != NULL)
     delete state_features;
+  if (next_state_features != NULL)
+    delete next_state_features;
 
   if (aggregate_features != NULL)
     delete aggregate_features;
 
+  disposeBanks();
+
+  if (candidate_scorer != NULL)
+    delete candidate_scorer;
+
   init();
   return;
 }
@@ -166,12 +224,14 @@ void WorkingMemory::copy(const WorkingMemory& src, WorkingMemory& dest) {
   dest.number_of_chunks = src.number_of_chunks;
   dest.number_of_active_chunks = src.number_of_active_chunks;
   dest.working_memory_store = new Chunk*[src.number_of_chunks];
+  dest.long_term_slots = new bool[src.number_of_chunks];
   dest.chunk_features = new ChunkFeatureVector*[src.number_of_chunks];
   for (x = 0; x < number_of_chunks; x++) {
     if (src.working_memory_store[x] != NULL)
       dest.working_memory_store[x] = new Chunk(*src.working_memory_store[x]);
     else
       dest.working_memory_store[x] = NULL;
+    dest.long_term_slots[x] = src.long_term_slots[x];
     dest.chunk_features[x] = NULL;
   }
   dest.state_data_structure = src.state_data_structure;
@@ -179,8 +239,10 @@ void WorkingMemory::copy(const WorkingMemory& src, WorkingMemory& dest) {
   dest.aggregate_features =
     new AggregateFeatureVector(*(src.aggregate_features));
   dest.critic_network = new CriticNetwork(*src.critic_network);
-  // Leaving this one for later
-  dest.actor_network = src.actor_network;
+  if (src.actor_network != NULL)
+    dest.actor_network = new ActorNetwork(*src.actor_network);
+  else
+    dest.actor_network = NULL;
   dest.reward_function = src.reward_function;
   dest.translate_state = src.translate_state;
   dest.translate_chunk = src.translate_chunk;
@@ -189,8 +251,32 @@ void WorkingMemory::copy(const WorkingMemory& src, WorkingMemory& dest) {
   dest.use_actor = src.use_actor;
   dest.the_or_code = src.the_or_code;
   dest.exploration_percentage = src.exploration_percentage;
+  dest.selection_policy = src.selection_policy;
+  dest.selection_gain = src.selection_gain;
   dest.last_reward = src.last_reward;
   dest.or_vector = new FeatureVector(*(src.or_vector));
+  dest.number_of_banks = src.number_of_banks;
+  if (src.banks != NULL) {
+    dest.banks = new WMBank[src.number_of_banks];
+    for (x = 0; x < src.number_of_banks; x++) {
+      dest.banks[x] = src.banks[x];
+      dest.banks[x].critic = new CriticNetwork(*src.banks[x].critic);
+      dest.banks[x].aggregate =
+	new AggregateFeatureVector(*src.banks[x].aggregate);
+      dest.banks[x].or_features = new FeatureVector(*src.banks[x].or_features);
+    }
+  }
+  dest.shortlist_size = src.shortlist_size;
+  dest.salience_function = src.salience_function;
+  if (src.candidate_scorer != NULL)
+    dest.candidate_scorer = new CandidateScorer(*src.candidate_scorer);
+  dest.long_term_memory = src.long_term_memory;
+  dest.retrieval_count = src.retrieval_count;
+  dest.cue_function = src.cue_function;
+  if (src.next_state_features != NULL)
+    dest.next_state_features =
+      new StateFeatureVector(*src.next_state_features);
+  dest.change_tolerances = src.change_tolerances;
   return;
 }
 
@@ -208,9 +294,11 @@ WorkingMemory::WorkingMemory(int wm_size,
 			     void (*user_chunk_function)(FeatureVector&, Chunk&,
 							 WorkingMemory&),
 			     void (*user_delete_function)(Chunk&),
-			     bool use_actor,
+			     bool use_actor_network,
 			     OR_CODE or_code,
-			     double mean_initial_values) {
+			     double mean_initial_values,
+			     CODING_SCHEME coding_scheme,
+			     int hash_buckets) {
 
   int x;
 
@@ -232,9 +320,11 @@ WorkingMemory::WorkingMemory(int wm_size,
   number_of_chunks = wm_size;
   number_of_active_chunks = 0;
   working_memory_store = new Chunk*[wm_size];
+  long_term_slots = new bool[wm_size];
   chunk_features = new ChunkFeatureVector*[wm_size];
   for (x = 0; x < wm_size; x++) {
     working_memory_store[x] = NULL;
+    long_term_slots[x] = false;
     chunk_features[x] = NULL;
   }
   if (state_feature_vector_size > 0)
@@ -250,30 +340,58 @@ WorkingMemory::WorkingMemory(int wm_size,
 #ifdef OR_ONLY
   aggregate_features =
     new AggregateFeatureVector(state_feature_vector_size,
-			       chunk_feature_vector_size + 1, 0); // OR only
+			       chunk_feature_vector_size + 1, 0,
+			       coding_scheme); // OR only
 #else
   aggregate_features =
     new AggregateFeatureVector(state_feature_vector_size,
 			       chunk_feature_vector_size + 1,
-			       number_of_chunks); // Normal
+			       number_of_chunks,
+			       coding_scheme,
+			       false,
+			       hash_buckets); // Normal
 #endif
 
-  critic_network = new CriticNetwork(aggregate_features->getSize());
+  critic_network = new CriticNetwork(aggregate_features->getSize(),
+				     LINEAR_ENGINE);
   UniformRandomNumberGenerator rng(mean_initial_values - 0.001,
 				   mean_initial_values + 0.001);
   critic_network->initializeWeights(rng);
-  // Leaving this one out until later
-  actor_network = NULL;
+  if (use_actor_network) {
+    actor_network = new ActorNetwork(state_feature_vector_size,
+				     chunk_feature_vector_size + 1,
+				     number_of_chunks);
+    UniformRandomNumberGenerator actor_rng(-0.001, 0.001);
+    actor_network->initializeWeights(actor_rng);
+  }
+  else
+    actor_network = NULL;
   reward_function = user_reward_function;
   translate_state = user_state_function;
   translate_chunk = user_chunk_function;
   delete_chunk = user_delete_function;
   episode_time = 0;
-  // Leaving this until later as well
-  use_actor = false;
+  use_actor = use_actor_network;
   the_or_code = or_code;
   exploration_percentage = MEMORY_EXPLORATION_PERCENTAGE;
+#ifdef USE_SOFTMAX
+  selection_policy = SOFTMAX_SELECTION;
+#else
+  selection_policy = EPSILON_GREEDY_SELECTION;
+#endif
+  selection_gain = MEMORY_SOFTMAX_GAIN;
   last_reward = 0.0;
+  banks = NULL;
+  number_of_banks = 0;
+  shortlist_size = 0;
+  salience_function = NULL;
+  candidate_scorer = NULL;
+  long_term_memory = NULL;
+  retrieval_count = 0;
+  cue_function = NULL;
+  next_state_features = NULL;
+  change_tolerances.clear();
+  translated_state = NULL;
 
   return;
 }
@@ -284,6 +402,7 @@ WorkingMemory::~WorkingMemory() {
 }
 
 WorkingMemory::WorkingMemory(const WorkingMemory& L) {
+  init();
   copy(L,*this);
   return;
 }
@@ -295,6 +414,55 @@ WorkingMemory& WorkingMemory::operator=(const WorkingMemory& Rhs) {
   return *this;
 }
 
+void WorkingMemory::swap(WorkingMemory& other) {
+  std::swap(state_vector_size, other.state_vector_size);
+  std::swap(chunk_vector_size, other.chunk_vector_size);
+  std::swap(number_of_chunks, other.number_of_chunks);
+  std::swap(number_of_active_chunks, other.number_of_active_chunks);
+  std::swap(working_memory_store, other.working_memory_store);
+  std::swap(long_term_slots, other.long_term_slots);
+  std::swap(chunk_features, other.chunk_features);
+  std::swap(state_data_structure, other.state_data_structure);
+  std::swap(state_features, other.state_features);
+  std::swap(or_vector, other.or_vector);
+  std::swap(aggregate_features, other.aggregate_features);
+  std::swap(critic_network, other.critic_network);
+  std::swap(actor_network, other.actor_network);
+  std::swap(reward_function, other.reward_function);
+  std::swap(translate_state, other.translate_state);
+  std::swap(translate_chunk, other.translate_chunk);
+  std::swap(delete_chunk, other.delete_chunk);
+  std::swap(episode_time, other.episode_time);
+  std::swap(use_actor, other.use_actor);
+  std::swap(the_or_code, other.the_or_code);
+  std::swap(last_reward, other.last_reward);
+  std::swap(exploration_percentage, other.exploration_percentage);
+  std::swap(selection_policy, other.selection_policy);
+  std::swap(selection_gain, other.selection_gain);
+  std::swap(banks, other.banks);
+  std::swap(number_of_banks, other.number_of_banks);
+  std::swap(shortlist_size, other.shortlist_size);
+  std::swap(salience_function, other.salience_function);
+  std::swap(candidate_scorer, other.candidate_scorer);
+  std::swap(long_term_memory, other.long_term_memory);
+  std::swap(retrieval_count, other.retrieval_count);
+  std::swap(cue_function, other.cue_function);
+  std::swap(next_state_features, other.next_state_features);
+  change_tolerances.swap(other.change_tolerances);
+}
+
+#if __cplusplus >= 201103L
+WorkingMemory::WorkingMemory(WorkingMemory&& L) noexcept {
+  init();
+  swap(L);
+}
+
+WorkingMemory& WorkingMemory::operator=(WorkingMemory&& Rhs) noexcept {
+  swap(Rhs);
+  return *this;
+}
+#endif
+
 int WorkingMemory::getWorkingMemorySize() const {
   return number_of_chunks;
 }
@@ -310,7 +478,13 @@ Chunk WorkingMemory::getChunk(int chunk_number) const {
   if (chunk_number < 0 || chunk_number >= number_of_active_chunks)
     return result;
 
-  return *working_memory_store[chunk_number];
+  // The chunks come first within each bank, but a bank may have empty
+  // slots before the next one.
+  for (int x = 0; x < number_of_chunks; x++)
+    if (working_memory_store[x] != NULL && chunk_number-- == 0)
+      return *working_memory_store[x];
+
+  return result;
 }
 
 void* WorkingMemory::getStateDataStructure() const {
@@ -325,20 +499,26 @@ bool WorkingMemory::newEpisode(bool clear_memory) {
   cout << endl << "***** NEW EPISODE *****" << endl << endl;
   #endif
 
-  int x, y;
+  int x, b;
   ChunkFeatureVector cfvector(chunk_vector_size + 1, translate_chunk);
   ChunkFeatureVector small_vector(chunk_vector_size, translate_chunk);
   cfvector.clearVector();
   cfvector.setValue(cfvector.getSize() - 1, WMTK_FV_MAX);
+
+  WMBank whole;
+  int bank_count;
+  WMBank* bank_list = listBanks(whole, bank_count);
   
-  // Need to absorb the reward from the last time step.
-  critic_network->processVector(*aggregate_features);
-  critic_network->processFinalTimeStep(last_reward);
+  // Need to absorb the reward from the last time step. (Each critic
+  // still holds the last aggregate vector as its current time step.)
+  for (b = 0; b < bank_count; b++)
+    bank_list[b].critic->processFinalTimeStep(last_reward);
   episode_time = 0;
-  critic_network->clearEligibilityTraces();
+  for (b = 0; b < bank_count; b++)
+    bank_list[b].critic->clearEligibilityTraces();
 
   // Set up initial state
-  state_features->updateFeatures(*this);
+  translateState(*state_features);
   last_reward = reward_function(*this);
 
   // Update WM contents and feature vectors
@@ -347,32 +527,39 @@ bool WorkingMemory::newEpisode(bool clear_memory) {
 
   for (x = 0; x < number_of_chunks; x++) {
     if (clear_memory && working_memory_store[x] != NULL) {
-      delete_chunk(*working_memory_store[x]);
+      if (!long_term_slots[x])
+	delete_chunk(*working_memory_store[x]);
       delete working_memory_store[x];
       working_memory_store[x] = NULL;
+      long_term_slots[x] = false;
     }
     if (working_memory_store[x] != NULL) {
       chunk_features[x] = new ChunkFeatureVector(chunk_vector_size + 1,
 						 translate_chunk);
       small_vector.clearVector();
       small_vector.updateFeatures(*(working_memory_store[x]), *this);
-      for (y = 0; y < chunk_vector_size; y++)
-	chunk_features[x]->setValue(y, small_vector.getValue(y));
+      chunk_features[x]->copyVector(small_vector);
     }
     else {
       chunk_features[x] = &cfvector;
     }
   }
 
-  // Create OR code
-  or_vector->clearVector();
-  for (x = 0; x < number_of_active_chunks; x++)
-    or_vector->makeORCode(*(chunk_features[x]), the_or_code);
-  
-  // Setup aggregate vector for first time step
-  aggregate_features->updateFeatures(*state_features, chunk_features,
-				    *or_vector);
-  
+  for (b = 0; b < bank_count; b++) {
+    WMBank& bank = bank_list[b];
+
+    // Create OR code
+    bank.or_features->clearVector();
+    for (x = bank.first_slot; x < bank.first_slot + bank.size; x++)
+      if (working_memory_store[x] != NULL)
+	bank.or_features->makeORCode(*(chunk_features[x]), the_or_code);
+
+    // Setup aggregate vector for first time step
+    bank.aggregate->updateFeatures(*state_features,
+				   chunk_features + bank.first_slot,
+				   *bank.or_features);
+    bank.critic->processVector(*bank.aggregate);
+  }
 
   // Clear chunk_features (allocated memory)
   for (x = 0; x < number_of_chunks; x++) {
@@ -389,28 +576,62 @@ int WorkingMemory::getEpisodeTime() const {
 }
 
 
-// BIG NOTE::
-// 	This function is supposed to run with either the critic only
-//      or using an actor. For right now it will ONLY use the critic
-//      by itself. The actor network portion has yet to be fully
-//      understood for this problem.
-//
 int WorkingMemory::tickEpisodeClock(list<Chunk>& candidate_chunks, bool learn) {
   if (critic_network == NULL)
     return episode_time;
 
-  int x, y, z;	// Local counters
+  // Update the state vector
+  translateState(*state_features);
 
-  // Store the last time step vector for later processing
-  AggregateFeatureVector* old_vector = 
-    new AggregateFeatureVector(*aggregate_features);
+  return advanceEpisode(candidate_chunks, learn);
+}
 
-  // Update the state vector
-  state_features->updateFeatures(*this);
+// The state is translated once into the spare vector, which becomes the
+// state vector only if the tick goes ahead. Otherwise the contents, the
+// state vector and the aggregate vectors stay as they are, and each
+// critic takes a time step from its vector to the same vector, which is
+// the TD update for the elapsed step.
+//
+int WorkingMemory::tickOnChange(list<Chunk>& candidate_chunks, double tolerance, bool learn) {
+  if (critic_network == NULL)
+    return episode_time;
+
+  if (stateChanged(tolerance) || !candidate_chunks.empty()) {
+    state_features->swap(*next_state_features);
+    return advanceEpisode(candidate_chunks, learn);
+  }
+
+  WMBank whole;
+  int bank_count;
+  WMBank* bank_list = listBanks(whole, bank_count);
+
+  for (int b = 0; b < bank_count; b++)
+    bank_list[b].critic->processVectorAsNextTimeStep(*bank_list[b].aggregate,
+						     last_reward, learn);
+
+  last_reward = reward_function(*this);
+
+  return ++episode_time;
+}
+
+// This function runs with either the critic only (which values every
+// assignment of the candidates to the slots) or with the actor (which
+// fills the slots itself, leaving the critic to value only the chosen
+// contents and to supply the TD error that trains the actor). The state
+// vector is already up to date.
+//
+int WorkingMemory::advanceEpisode(list<Chunk>& candidate_chunks, bool learn) {
+  int x, b;	// Local counters
+
+  // Add the long-term chunks that best match the state to the candidates
+  // (those from the first_retrieved on)
+  int first_retrieved = candidate_chunks.size();
+  if (long_term_memory != NULL && retrieval_count > 0)
+    first_retrieved -= retrieveCandidates(candidate_chunks);
 
   #ifdef WMTK_DEBUG
   cout << "***** BEGIN *****" << endl;
-  cout << "Old Aggregate Vector: " << *old_vector << endl;
+  cout << "Old Aggregate Vector: " << *aggregate_features << endl;
   cout << "New State Vector: " << *state_features << endl;
   cout << "Number of Chunks in Memory: " << number_of_active_chunks << endl;
   cout << "Number of Chunks in Candidate List: " << candidate_chunks.size()
@@ -424,94 +645,329 @@ int WorkingMemory::tickEpisodeClock(list<Chunk>& candidate_chunks, bool learn) {
   cout << endl;
   #endif
 
-  // Copy candidate chunks list into vector of new objects
-  vector<Chunk*> all_chunks;
+  WMBank whole;
+  int bank_count;
+  WMBank* bank_list = listBanks(whole, bank_count);
+
+  // Move candidate chunks list into vectors of new objects, one for each
+  // bank (the list is emptied below, so its chunks are swapped out rather
+  // than copied). A candidate goes to the first bank that accepts its
+  // type; those that no bank accepts are disposed of. The chunks from the
+  // long-term memory are flagged in long_term, so that they are never
+  // passed to delete_chunk.
+  vector< vector<Chunk*> > all_chunks(bank_count);
+  vector< vector<bool> > long_term(bank_count);
+  for (b = 0; b < bank_count; b++)
+    all_chunks[b].reserve(candidate_chunks.size() + bank_list[b].size);
+  x = 0;
   for (list<Chunk>::iterator itr = candidate_chunks.begin();
-       itr != candidate_chunks.end(); itr++)
-    all_chunks.push_back(new Chunk(*itr));
+       itr != candidate_chunks.end(); itr++, x++) {
+    for (b = 0; b < bank_count; b++)
+      if (bank_list[b].type.empty() || bank_list[b].type == itr->getType())
+	break;
+    if (b == bank_count) {
+      if (x < first_retrieved)
+	delete_chunk(*itr);
+      continue;
+    }
+    all_chunks[b].push_back(new Chunk());
+    all_chunks[b].back()->swap(*itr);
+    long_term[b].push_back(x >= first_retrieved);
+  }
 
   // Empty candidate chunks list
   while (!candidate_chunks.empty())
     candidate_chunks.pop_front();
 
-  // Add chunks currently in working memory to all_chunks vector
-  for (x = 0; x < number_of_active_chunks; x++)
-    all_chunks.push_back(working_memory_store[x]);
+  // Number of new candidates of each bank (they come before the chunks
+  // already in memory)
+  vector<int> candidate_counts(bank_count);
+  for (b = 0; b < bank_count; b++)
+    candidate_counts[b] = all_chunks[b].size();
+
+  // Add chunks currently in working memory to the all_chunks vectors of
+  // their banks (the empty slots need not come last)
+  for (b = 0; b < bank_count; b++)
+    for (x = bank_list[b].first_slot;
+	 x < bank_list[b].first_slot + bank_list[b].size; x++)
+      if (working_memory_store[x] != NULL) {
+	all_chunks[b].push_back(working_memory_store[x]);
+	long_term[b].push_back(long_term_slots[x]);
+      }
 
   // Clear WM contents
   number_of_active_chunks = 0;
-  for (x = 0; x < number_of_chunks; x++)
+  for (x = 0; x < number_of_chunks; x++) {
     working_memory_store[x] = NULL;
+    long_term_slots[x] = false;
+  }
 
   // Translate all chunks in all_chunks into feature vectors
-  vector<ChunkFeatureVector> chunk_translations;
+  vector< vector<ChunkFeatureVector> > chunk_translations(bank_count);
   ChunkFeatureVector cfvector(chunk_vector_size + 1, translate_chunk);
   ChunkFeatureVector small_cfvector(chunk_vector_size, translate_chunk);
-  for (x = 0; x < all_chunks.size(); x++) {
-    small_cfvector.clearVector();
-    small_cfvector.updateFeatures(*(all_chunks[x]), *this);
-    cfvector.clearVector();
-    for (y = 0; y < chunk_vector_size; y++)
-      cfvector.setValue(y, small_cfvector.getValue(y));
-    chunk_translations.push_back(cfvector);
+  for (b = 0; b < bank_count; b++) {
+    int candidates = all_chunks[b].size();
+    chunk_translations[b].reserve(candidates);
+    for (x = 0; x < candidates; x++) {
+      small_cfvector.clearVector();
+      small_cfvector.updateFeatures(*(all_chunks[b][x]), *this);
+      cfvector.clearVector();
+      cfvector.copyVector(small_cfvector);
+      chunk_translations[b].push_back(cfvector);
+    }
   }
   cfvector.clearVector(); // cfvector is now a NULL vector ("EMPTY")
   cfvector.setValue(cfvector.getSize() - 1, WMTK_FV_MAX);
 
+  // Cut the new candidates of each bank down to a shortlist before the
+  // search
+  bool shortlisting = (shortlist_size > 0 && !use_actor);
+  if (shortlisting)
+    for (b = 0; b < bank_count; b++)
+      shortlistCandidates(candidate_counts[b], all_chunks[b],
+			  chunk_translations[b], long_term[b]);
+
   #ifdef WMTK_DEBUG
   cout << "VECTORS:" << endl;
   cout << "-1: " << cfvector << endl;
-  for (x = 0; x < chunk_translations.size(); x++)
-    cout << x << ": " << chunk_translations[x] << endl;
+  for (b = 0; b < bank_count; b++)
+    for (x = 0; x < chunk_translations[b].size(); x++)
+      cout << b << "." << x << ": " << chunk_translations[b][x] << endl;
   #endif
 
-  // Keep values of all combinations in vector
+  // Chosen combination of each bank
+  vector<WMCombo*> selections(bank_count, (WMCombo*) NULL);
+
+  if (use_actor) {
+    // The actor fills the slots in one pass over the candidates; only
+    // the contents it chooses are valued by the critic. (There are no
+    // banks with an actor.)
+    int translated = chunk_translations[0].size();
+    vector<const FeatureVector*> candidates(translated);
+    for (x = 0; x < translated; x++)
+      candidates[x] = &chunk_translations[0][x];
+
+    selections[0] = new WMCombo;
+    selections[0]->chunks = new int[number_of_chunks];
+    actor_network->evaluateCandidates(*state_features,
+				      candidates.empty() ? NULL :
+				      &candidates[0],
+				      candidates.size(), cfvector);
+    actor_network->selectChunks(selections[0]->chunks);
+
+    assignChunkFeatures(selections[0]->chunks, 0, number_of_chunks,
+			*or_vector, chunk_translations[0], cfvector);
+    aggregate_features->setFactors(*state_features, chunk_features,
+				   *or_vector);
+    selections[0]->value =
+      critic_network->evaluateAggregate(*aggregate_features);
+  }
+  else {
+    // Each bank is searched on its own, so the cost of the search is the
+    // sum of the costs for the banks rather than their product. The
+    // search also yields the marginal values that train the shortlist's
+    // scorer.
+    bool train_scorer = (learn && ((shortlisting && salience_function == NULL) ||
+				   (long_term_memory != NULL &&
+				    cue_function == NULL)));
+    vector<double> marginals;
+    for (b = 0; b < bank_count; b++) {
+      int candidates = all_chunks[b].size();
+      marginals.resize(candidates);
+      selections[b] = searchContents(bank_list[b], all_chunks[b],
+				     chunk_translations[b], cfvector,
+				     (train_scorer && !marginals.empty()) ?
+				     &marginals[0] : NULL);
+      if (train_scorer)
+	for (x = 0; x < candidates; x++)
+	  candidate_scorer->learn(*state_features, chunk_translations[b][x],
+				  marginals[x]);
+    }
+  }
+
+  // Apply selected contents to memory
+  for (b = 0; b < bank_count; b++) {
+    WMBank& bank = bank_list[b];
+    const int* contents = selections[b]->chunks;
+
+    number_of_active_chunks +=
+      assignChunkFeatures(contents, bank.first_slot, bank.size,
+			  *bank.or_features, chunk_translations[b], cfvector);
+    for (x = 0; x < bank.size; x++)
+      if (contents[x] >= 0) {
+	working_memory_store[bank.first_slot + x] =
+	  all_chunks[b][contents[x]];
+	long_term_slots[bank.first_slot + x] = long_term[b][contents[x]];
+	// Once a chunk is used, make the pointer NULL
+	// All non-null pointers in the vector will be deleted later
+	all_chunks[b][contents[x]] = NULL;
+      }
+      else
+	working_memory_store[bank.first_slot + x] = NULL;
+
+    // Fill out aggregate feature vector
+    bank.aggregate->updateFeatures(*state_features,
+				   chunk_features + bank.first_slot,
+				   *bank.or_features);
+
+#ifdef WMTK_DEBUG
+    cout << "OR vector: " << *bank.or_features << endl;
+    cout << "New Aggregate Vector: " << *bank.aggregate << endl;
+#endif
+  }
+
+#ifdef WMTK_DEBUG
+  cout << "***** END *****" << endl << endl;
+#endif
+
+  // Clean all unused chunks
+  for (b = 0; b < bank_count; b++) {
+    int candidates = all_chunks[b].size();
+    for (x = 0; x < candidates; x++)
+      if (all_chunks[b][x] != NULL) {
+	if (!long_term[b][x])
+	  delete_chunk(*(all_chunks[b][x]));
+	delete all_chunks[b][x];
+      }
+  }
+
+  // Clear chunk_features (all point to vectors on the stack)
+  for (x = 0; x < number_of_chunks; x++)
+    chunk_features[x] = NULL;
+
+  // Learning
+  // Each critic still holds the old vector as its current time step, and
+  // the value of the new one is already known from the search.
+  for (b = 0; b < bank_count; b++)
+    bank_list[b].critic->processVectorAsNextTimeStep(*bank_list[b].aggregate,
+						     selections[b]->value,
+						     last_reward,
+						     learn);
+  // The TD error of the move to the chosen contents trains the actor.
+  if (use_actor && learn)
+    actor_network->learn(critic_network->getTDError());
+
+  // Clean selected combinations
+  for (b = 0; b < bank_count; b++) {
+    delete [] selections[b]->chunks;
+    delete selections[b];
+  }
+
+  // Get reward value needed for later.
+  last_reward = reward_function(*this);
+
+  return ++episode_time;
+}
+
+WMCombo* WorkingMemory::searchContents(WMBank& bank, vector<Chunk*>& chunks, vector<ChunkFeatureVector>& translations, ChunkFeatureVector& empty, double* marginals) {
+  int x, y, z;	// Local counters
   vector<WMCombo*> combinations;
   WMCombo* combination_ptr = NULL;
 
+  // A softmax draw need not value every combination (unless the values
+  // are needed for the marginals).
+  if (selection_policy == SOFTMAX_SELECTION && marginals == NULL) {
+    combination_ptr = sampleContents(bank, chunks, translations, empty);
+    if (combination_ptr != NULL)
+      return combination_ptr;
+  }
+
   // Go through all combinations and store the values of the combinations.
-  int* pass_counter = new int[number_of_chunks];
-  for (x = 0; x < number_of_chunks; x++) {
+  int* pass_counter = new int[bank.size];
+  for (x = 0; x < bank.size; x++) {
     pass_counter[x] = -1;
   }
-  
+
+  // With tied slots, the value of a combination is the sum of the
+  // scores of its chunks (the empty vector being candidate
+  // chunks.size()), of their pairs and of the state and OR vectors, and
+  // only the combination with its chunks in candidate order is searched
+  // (the empty slots already come last).
+  bool tied = (bank.critic->getEngine() == TIED_ENGINE);
+  int scored = chunks.size() + 1;
+  double* chunk_scores = NULL;
+  double* pair_scores = NULL;
+  double context_score = 0.0;
+  if (tied) {
+    vector<const FeatureVector*> scored_vectors(scored);
+    for (x = 0; x < scored - 1; x++)
+      scored_vectors[x] = &translations[x];
+    scored_vectors[scored - 1] = &empty;
+
+    chunk_scores = new double[scored];
+    pair_scores = new double[scored * scored];
+    if (bank.critic->scoreChunks(scored, &scored_vectors[0],
+				 chunk_scores) &&
+	bank.critic->scoreChunkPairs(scored, &scored_vectors[0],
+				     pair_scores)) {
+      bank.or_features->clearVector();
+      context_score = bank.critic->scoreContext(*state_features,
+						*bank.or_features);
+    }
+    else {
+      // Evaluate every combination instead.
+      delete [] chunk_scores;
+      delete [] pair_scores;
+      chunk_scores = NULL;
+      pair_scores = NULL;
+      tied = false;
+    }
+  }
+
   bool carry = false;
   while (!carry) {
     bool duplicate = false;
-    for (y = 0; y < number_of_chunks; y++)
-      for (z = 0; z < number_of_chunks; z++)
+    for (y = 0; y < bank.size; y++)
+      for (z = 0; z < bank.size; z++)
 	if (pass_counter[y] == pass_counter[z] && pass_counter[y] !=
 	    -1 && y != z)
 	  duplicate = true;
-    
+    if (tied)
+      for (y = 1; y < bank.size; y++)
+	if (pass_counter[y] != -1 && pass_counter[y] < pass_counter[y - 1])
+	  duplicate = true;
+
     // Do test on combination - no duplications allowed
     if (!duplicate) {
       combination_ptr = new WMCombo;
-      combination_ptr->chunks = new int[number_of_chunks];
-      for (y = 0; y < number_of_chunks; y++)
+      combination_ptr->chunks = new int[bank.size];
+      for (y = 0; y < bank.size; y++)
 	combination_ptr->chunks[y] = pass_counter[y];
 
-      // Assign feature vectors
-      number_of_active_chunks = 0;
-      for (x = 0; x < number_of_chunks; x++)
-	if (combination_ptr->chunks[x] >= 0) {
-	  number_of_active_chunks++;
-	  chunk_features[x] = &chunk_translations[combination_ptr->chunks[x]];
+      if (tied) {
+	// Only the OR vector needs to be built.
+	if (the_or_code != NO_OR) {
+	  assignChunkFeatures(combination_ptr->chunks, bank.first_slot,
+			      bank.size, *bank.or_features, translations,
+			      empty);
+	  context_score = bank.critic->scoreContext(*state_features,
+						    *bank.or_features);
 	}
-	else {
-	  chunk_features[x] = &cfvector;
+	combination_ptr->value = context_score;
+	for (y = 0; y < bank.size; y++) {
+	  x = (pass_counter[y] == -1) ? scored - 1 : pass_counter[y];
+	  combination_ptr->value += chunk_scores[x];
+	  for (z = 0; z < y; z++)
+	    combination_ptr->value +=
+	      pair_scores[(x * scored) +
+			  ((pass_counter[z] == -1) ? scored - 1 :
+			   pass_counter[z])];
 	}
-	
-      // Create OR code
-      or_vector->clearVector();
-      for (x = 0; x < number_of_active_chunks; x++)
-	or_vector->makeORCode(*(chunk_features[x]), the_or_code);
-	
-      // Fill out aggregate feature vector
-      aggregate_features->updateFeatures(*state_features, chunk_features,
-					 *or_vector);
-      combination_ptr->value =
-	critic_network->processVector(*aggregate_features);
+      }
+      else {
+	// Assign feature vectors and create OR code
+	assignChunkFeatures(combination_ptr->chunks, bank.first_slot,
+			    bank.size, *bank.or_features, translations, empty);
+
+	// Record the factors of the aggregate feature vector; the critic
+	// evaluates them without building the conjunctive code.
+	bank.aggregate->setFactors(*state_features,
+				   chunk_features + bank.first_slot,
+				   *bank.or_features);
+	combination_ptr->value =
+	  bank.critic->evaluateAggregate(*bank.aggregate);
+      }
 
       // Store this combination and its value
       combinations.push_back(combination_ptr);
@@ -520,25 +976,58 @@ int WorkingMemory::tickEpisodeClock(list<Chunk>& candidate_chunks, bool learn) {
 
     // Increment combination counters
     carry = true;
-    for (y = 0; y < number_of_chunks && carry; y++) {
+    for (y = 0; y < bank.size && carry; y++) {
       pass_counter[y]++;
-      if (pass_counter[y] < all_chunks.size())
+      if (pass_counter[y] < chunks.size())
 	carry = false;
       else
 	pass_counter[y] = 0;
     }
   }
   delete [] pass_counter; // Finished with pass_counter
+  if (tied) {
+    delete [] chunk_scores;
+    delete [] pair_scores;
+  }
+
+  // The marginal value of a chunk is the value of the best combination
+  // that holds it less that of the best one that does not.
+  if (marginals != NULL) {
+    int count = chunks.size();
+    int combined = combinations.size();
+    double* best_without = new double[count];
+    bool* held = new bool[count];
+    for (x = 0; x < count; x++) {
+      marginals[x] = -HUGE_VAL;
+      best_without[x] = -HUGE_VAL;
+    }
+    for (z = 0; z < combined; z++) {
+      for (x = 0; x < count; x++)
+	held[x] = false;
+      for (y = 0; y < bank.size; y++)
+	if (combinations[z]->chunks[y] >= 0)
+	  held[combinations[z]->chunks[y]] = true;
+      for (x = 0; x < count; x++)
+	if (held[x])
+	  marginals[x] = max(marginals[x], combinations[z]->value);
+	else
+	  best_without[x] = max(best_without[x], combinations[z]->value);
+    }
+    for (x = 0; x < count; x++)
+      marginals[x] -= best_without[x];
+    delete [] best_without;
+    delete [] held;
+  }
 
 #ifdef WMTK_DEBUG
   cout << "COMBINATIONS" << endl;
   for (x = 0; x < combinations.size(); x++) {
     cout << x << ": " << combinations[x]->value << " | ";
-    for (y = 0; y < number_of_chunks; y++) {
+    for (y = 0; y < bank.size; y++) {
       if (combinations[x]->chunks[y] == -1)
 	cout << "EMPTY ";
       else
-	cout << all_chunks[combinations[x]->chunks[y]]->getType() << " ";      
+	cout << chunks[combinations[x]->chunks[y]]->getType() << " ";
     }
     cout << endl;
   }
@@ -550,95 +1039,253 @@ int WorkingMemory::tickEpisodeClock(list<Chunk>& candidate_chunks, bool learn) {
     values[x] = combinations[x]->value;
 
   // Choose the combination to use using the chosen method
-#ifdef USE_SOFTMAX
-  // Gibbs Softmax
-  double* percentages = new double[combinations.size()];
-  applySoftmax(SM_CONSTANT, combinations.size(), values, percentages);
-  
-  double c_percent = 0.0;
-  double select_percent = 1.0 * rand() / (RAND_MAX + 1.0);
-  for (x = 0; x < combinations.size(); x++) {
-    c_percent += percentages[x];
-    if (select_percent < c_percent) {
-      selection = x;
-      break;
+  if (selection_policy == SOFTMAX_SELECTION) {
+    // Gibbs Softmax
+    int combined = combinations.size();
+    double* percentages = new double[combined];
+    applySoftmax(selection_gain, combined, values, percentages);
+
+    double c_percent = 0.0;
+    double select_percent = 1.0 * rand() / (RAND_MAX + 1.0);
+    for (x = 0; x < combined; x++) {
+      c_percent += percentages[x];
+      if (select_percent < c_percent) {
+	selection = x;
+	break;
+      }
     }
+    delete [] percentages; // Finished with percentages
+  }
+  else {
+    // Epsilon-Greedy
+    if ((1.0 * rand() / (RAND_MAX + 1.0)) < exploration_percentage)
+      selection = (int) (((double) combinations.size()) * random() /
+			 (RAND_MAX + 1.0));
+    else
+      selection = getIndexOfMaximum(combinations.size(), values);
   }
-  delete [] percentages; // Finished with percentages
-#else
-  // Epsilon-Greedy
-  if ((1.0 * rand() / (RAND_MAX + 1.0)) < exploration_percentage)
-    selection = (int) (((double) combinations.size()) * random() /
-		       (RAND_MAX + 1.0));
-  else
-    selection = getIndexOfMaximum(combinations.size(), values);
-#endif
   delete [] values; // Finished with values
 
-  // Apply selected combination to memory
-  combination_ptr = combinations[selection];
+#ifdef WMTK_DEBUG
+  cout << "Selected Combination: " << selection << endl;
+#endif
 
-  // Assign feature vectors
-  number_of_active_chunks = 0;
-  for (x = 0; x < number_of_chunks; x++)
-    if (combination_ptr->chunks[x] >= 0) {
-      number_of_active_chunks++;
-      chunk_features[x] = &chunk_translations[combination_ptr->chunks[x]];
-      working_memory_store[x] =
-	all_chunks[combinations[selection]->chunks[x]];
-      // Once a chunk is used, make the pointer NULL
-      // All non-null pointers in the vector will be deleted later
-      all_chunks[combinations[selection]->chunks[x]] = NULL;
+  // Clean the other combinations
+  for (x = 0; x < combinations.size(); x++)
+    if (x != selection) {
+      delete [] combinations[x]->chunks;
+      delete combinations[x];
     }
-    else {
-      working_memory_store[x] = NULL;
-      chunk_features[x] = &cfvector;
+
+  return combinations[selection];
+}
+
+int WorkingMemory::assignChunkFeatures(const int* contents, int first_slot, int slots, FeatureVector& or_features, vector<ChunkFeatureVector>& translations, ChunkFeatureVector& empty) {
+  int x;
+  int active = 0;
+  ChunkFeatureVector** features = chunk_features + first_slot;
+
+  // Assign feature vectors
+  for (x = 0; x < slots; x++)
+    if (contents[x] >= 0) {
+      active++;
+      features[x] = &translations[contents[x]];
     }
-    
+    else
+      features[x] = &empty;
+
   // Create OR code
-  or_vector->clearVector();
-  for (x = 0; x < number_of_active_chunks; x++)
-    or_vector->makeORCode(*(chunk_features[x]), the_or_code);
-    
-  // Fill out aggregate feature vector
-  aggregate_features->updateFeatures(*state_features, chunk_features,
-				     *or_vector);
+  or_features.clearVector();
+  for (x = 0; x < active; x++)
+    or_features.makeORCode(*(features[x]), the_or_code);
 
-#ifdef WMTK_DEBUG
-  cout << "Selected Combination: " << selection << endl;
-  cout << "OR vector: " << *or_vector << endl;
-  cout << "New Aggregate Vector: " << *aggregate_features << endl;
-  cout << "***** END *****" << endl << endl;
-#endif
+  return active;
+}
 
-  // Clean combinations
-  for (x = 0; x < combinations.size(); x++) {
-    delete [] combinations[x]->chunks;
-    delete combinations[x];
-  };
+// With the value a sum of one term per slot, the softmax weight of a
+// combination is the product of one weight per slot. The table holds,
+// for each number i of candidates and set S of slots, the total weight
+// of the ways to place some of the first i candidates in exactly the
+// slots of S (one candidate per slot), so the total weight of all of the
+// combinations (the first m slots filled and the others empty) comes
+// from its last row. Walking back up the table, each candidate is then
+// left out or placed in a slot with probability in proportion to the
+// weight of the ways through that choice, which draws a combination
+// with probability in proportion to its weight. With tied slots, only
+// the combinations with their chunks in candidate order are searched,
+// so a candidate can only go in the slot after those already filled.
+WMCombo* WorkingMemory::sampleContents(WMBank& bank, vector<Chunk*>& chunks, vector<ChunkFeatureVector>& translations, ChunkFeatureVector& empty) {
+  if (the_or_code != NO_OR || bank.size > SAMPLER_MAX_SLOTS)
+    return NULL;
+
+  bool in_order = (bank.critic->getEngine() == TIED_ENGINE);
+  if (in_order ? bank.critic->hasPairScores() :
+      (bank.critic->getEngine() != LINEAR_ENGINE ||
+       bank.aggregate->getCodingScheme() != CONCAT))
+    return NULL;
+
+  int slots = bank.size;
+  int count = chunks.size();
+  int scored = count + 1; // The empty vector is scored last.
+  int sets = 1 << slots;
+  int x, y, set, bit;
+  double largest, total, draw;
+
+  // Weight of each vector in each slot (relative to the largest in the
+  // slot, which cancels out)
+  vector<const FeatureVector*> vectors(scored);
+  for (x = 0; x < count; x++)
+    vectors[x] = &translations[x];
+  vectors[count] = &empty;
+
+  vector<double> weights(slots * scored);
+  for (y = 0; y < slots; y++)
+    if (!(in_order ?
+	  bank.critic->scoreChunks(scored, &vectors[0],
+				   &weights[y * scored]) :
+	  bank.critic->scoreVectorsAt(state_vector_size +
+				      (y * (chunk_vector_size + 1)),
+				      scored, &vectors[0],
+				      &weights[y * scored])))
+      return NULL;
+  for (y = 0; y < slots; y++) {
+    largest = weights[y * scored];
+    for (x = 1; x < scored; x++)
+      largest = max(largest, weights[(y * scored) + x]);
+    for (x = 0; x < scored; x++)
+      weights[(y * scored) + x] =
+	exp(selection_gain * (weights[(y * scored) + x] - largest));
+  }
 
-  // Clean all unused chunks
-  for (x = 0; x < all_chunks.size(); x++)
-    if (all_chunks[x] != NULL) {
-      delete_chunk(*(all_chunks[x]));
-      delete all_chunks[x];
+  vector<double> table((count + 1) * sets, 0.0);
+  table[0] = 1.0;
+  for (x = 0; x < count; x++)
+    for (set = 0; set < sets; set++) {
+      total = table[(x * sets) + set];
+      for (y = 0; y < slots; y++) {
+	bit = 1 << y;
+	if ((set & bit) == 0 ||
+	    (in_order && (((set + 1) & set) != 0 || (set >> (y + 1)) != 0)))
+	  continue;
+	total += table[(x * sets) + (set ^ bit)] * weights[(y * scored) + x];
+      }
+      table[((x + 1) * sets) + set] = total;
     }
 
-  // Clear chunk_features (all point to vectors on the stack)
-  for (x = 0; x < number_of_chunks; x++)
-    chunk_features[x] = NULL;
+  // Total weight of the combinations with the first m slots filled
+  vector<double> filled(slots + 1);
+  total = 0.0;
+  for (y = 0; y <= slots; y++) {
+    filled[y] = table[(count * sets) + ((1 << y) - 1)];
+    for (x = y; x < slots; x++)
+      filled[y] *= weights[(x * scored) + count];
+    total += filled[y];
+  }
+  if (!(total > 0.0 && total < HUGE_VAL))
+    return NULL;
+
+  WMCombo* combination_ptr = new WMCombo;
+  combination_ptr->chunks = new int[slots];
+  for (y = 0; y < slots; y++)
+    combination_ptr->chunks[y] = -1;
+
+  draw = total * rand() / (RAND_MAX + 1.0);
+  for (y = 0; y < slots && draw >= filled[y]; y++)
+    draw -= filled[y];
+  set = (1 << y) - 1;
+
+  for (x = count - 1; x >= 0 && set != 0; x--) {
+    draw = table[((x + 1) * sets) + set] * rand() / (RAND_MAX + 1.0);
+    draw -= table[(x * sets) + set]; // Candidate x left out
+    if (draw < 0.0)
+      continue;
+    int slot = -1;
+    for (y = 0; y < slots; y++) {
+      bit = 1 << y;
+      if ((set & bit) == 0 ||
+	  (in_order && (set >> (y + 1)) != 0) ||
+	  table[(x * sets) + (set ^ bit)] == 0.0)
+	continue;
+      slot = y;
+      draw -= table[(x * sets) + (set ^ bit)] * weights[(y * scored) + x];
+      if (draw < 0.0)
+	break;
+    }
+    if (slot >= 0) {
+      combination_ptr->chunks[slot] = x;
+      set ^= 1 << slot;
+    }
+  }
 
-  // Learning
-  // Process the old vector
-  critic_network->processVector(*old_vector);
-  critic_network->processVectorAsNextTimeStep(*aggregate_features,
-					      last_reward,
-					      learn);
-  // Get reward value needed for later.
-  last_reward = reward_function(*this);
-  delete old_vector;
+  // Value the chosen contents with the critic
+  assignChunkFeatures(combination_ptr->chunks, bank.first_slot, bank.size,
+		      *bank.or_features, translations, empty);
+  bank.aggregate->setFactors(*state_features,
+			     chunk_features + bank.first_slot,
+			     *bank.or_features);
+  combination_ptr->value = bank.critic->evaluateAggregate(*bank.aggregate);
 
-  return ++episode_time;
+  return combination_ptr;
+}
+
+void WorkingMemory::shortlistCandidates(int count, vector<Chunk*>& chunks, vector<ChunkFeatureVector>& translations, vector<bool>& long_term) {
+  if (count <= shortlist_size)
+    return;
+
+  int x;
+  int kept = 0;
+  int candidates = chunks.size();
+
+  // Rank the candidates by score, best first (and in order among equal
+  // scores).
+  vector< pair<double, int> > ranks(count);
+  for (x = 0; x < count; x++)
+    if (salience_function != NULL)
+      ranks[x] = make_pair(-salience_function(*(chunks[x]), *this), x);
+    else
+      ranks[x] = make_pair(-candidate_scorer->score(*state_features,
+						    translations[x]), x);
+  partial_sort(ranks.begin(), ranks.begin() + shortlist_size, ranks.end());
+
+  vector<bool> keep(count, false);
+  for (x = 0; x < shortlist_size; x++)
+    keep[ranks[x].second] = true;
+
+  // Dispose of the rest, keeping the order of the others (the chunks in
+  // memory are always kept)
+  for (x = 0; x < candidates; x++)
+    if (x >= count || keep[x]) {
+      if (kept != x) {
+	chunks[kept] = chunks[x];
+	translations[kept].swap(translations[x]);
+	long_term[kept] = long_term[x];
+      }
+      kept++;
+    }
+    else {
+      if (!long_term[x])
+	delete_chunk(*(chunks[x]));
+      delete chunks[x];
+    }
+  chunks.resize(kept);
+  long_term.resize(kept);
+  translations.erase(translations.begin() + kept, translations.end());
+}
+
+WMBank* WorkingMemory::listBanks(WMBank& whole, int& count) const {
+  if (number_of_banks > 0) {
+    count = number_of_banks;
+    return banks;
+  }
+
+  whole.first_slot = 0;
+  whole.size = number_of_chunks;
+  whole.type = "";
+  whole.critic = critic_network;
+  whole.aggregate = aggregate_features;
+  whole.or_features = or_vector;
+  count = 1;
+  return &whole;
 }
 
 bool WorkingMemory::isUsingActor() const {
@@ -664,9 +1311,14 @@ bool WorkingMemory::saveNetwork(string filename) {
   if (output.bad())
     return false;
 
-  return critic_network->writeWeights(output);
-  //return critic_network->writeWeights(output) &&
-  //		 actor_network->writeWeights(output);
+  // Once banks are set, their critics stand in for the main one.
+  bool result = (number_of_banks > 0 || critic_network->writeWeights(output));
+  for (int x = 0; x < number_of_banks && result; x++)
+    result = banks[x].critic->writeWeights(output);
+
+  return result &&
+    (actor_network == NULL || actor_network->writeWeights(output)) &&
+    (candidate_scorer == NULL || candidate_scorer->writeWeights(output));
 }
 
 bool WorkingMemory::loadNetwork(string filename) {
@@ -679,9 +1331,14 @@ bool WorkingMemory::loadNetwork(string filename) {
   if (!input.is_open() || input.bad())
     return false;
 
-  return critic_network->readWeights(input);
-  //return critic_network->readWeights(input) &&
-  //		 actor_network->readWeights(input);
+  // Once banks are set, their critics stand in for the main one.
+  bool result = (number_of_banks > 0 || critic_network->readWeights(input));
+  for (int x = 0; x < number_of_banks && result; x++)
+    result = banks[x].critic->readWeights(input);
+
+  return result &&
+    (actor_network == NULL || actor_network->readWeights(input)) &&
+    (candidate_scorer == NULL || candidate_scorer->readWeights(input));
 }
 
 bool WorkingMemory::setExplorationPercentage(double val) {
@@ -697,28 +1354,395 @@ double WorkingMemory::getExplorationPercentage() const {
   return exploration_percentage;
 }
 
+double WorkingMemory::getHashCollisionRate() const {
+  return aggregate_features->getHashCollisionRate();
+}
+
+CODING_SCHEME WorkingMemory::getCodingScheme() const {
+  return aggregate_features->getCodingScheme();
+}
+
 CriticNetwork* WorkingMemory::getCriticNetwork() const {
   return critic_network;
 }
 
+ActorNetwork* WorkingMemory::getActorNetwork() const {
+  return actor_network;
+}
+
+bool WorkingMemory::setCriticEngine(CRITIC_ENGINE engine, int size, HIDDEN_ACTIVATION hidden_activation, SLOT_TYING slot_tying, double mean_initial_values) {
+  if (critic_network == NULL || number_of_active_chunks > 0 ||
+      number_of_banks > 0)
+    return false;
+
+  CODING_SCHEME coding_scheme = aggregate_features->getCodingScheme();
+  bool factored = (engine == LOW_RANK_ENGINE);
+
+  switch (engine) {
+  case NNET_ENGINE:
+  case LINEAR_ENGINE:
+    if (size != 0)
+      return false;
+    break;
+  case LOW_RANK_ENGINE:
+    if (size < 1 ||
+	(coding_scheme != WM_CONJ && coding_scheme != COMPLETE_CONJ))
+      return false;
+    break;
+  case HIDDEN_ENGINE:
+    if (size < 1)
+      return false;
+    break;
+  case TIED_ENGINE:
+    if (size != 0 || coding_scheme != CONCAT || slot_tying == UNTIED_SLOTS)
+      return false;
+    break;
+  default:
+    return false;
+  }
+#ifdef OR_ONLY
+  // (The OR only code holds neither the slots nor their conjunctions.)
+  if (engine == LOW_RANK_ENGINE || engine == TIED_ENGINE)
+    return false;
+#endif
+
+  // Only the low rank engine takes the factored form of the code.
+  AggregateFeatureVector* aggregate = aggregate_features;
+  if (factored != aggregate_features->isFactored())
+    aggregate =
+      new AggregateFeatureVector(state_vector_size, chunk_vector_size + 1,
+				 number_of_chunks, coding_scheme, factored,
+				 aggregate_features->getHashBuckets());
+
+  CriticNetwork* critic;
+  if (engine == LOW_RANK_ENGINE)
+    critic = new CriticNetwork(state_vector_size, chunk_vector_size + 1,
+			       number_of_chunks, size,
+			       aggregate->conjunctsState());
+  else if (engine == HIDDEN_ENGINE)
+    critic = new CriticNetwork(aggregate->getSize(), 1, &size,
+			       hidden_activation);
+  else if (engine == TIED_ENGINE)
+    critic = new CriticNetwork(state_vector_size, chunk_vector_size + 1,
+			       number_of_chunks,
+			       slot_tying == TIED_SLOTS_AND_PAIRS);
+  else
+    critic = new CriticNetwork(aggregate->getSize(), engine);
+
+  if (critic->getInputSize() < 1 ||
+      critic->getInputSize() != aggregate->getSize()) {
+    delete critic;
+    if (aggregate != aggregate_features)
+      delete aggregate;
+    return false;
+  }
+
+  delete critic_network;
+  critic_network = critic;
+  if (aggregate != aggregate_features) {
+    delete aggregate_features;
+    aggregate_features = aggregate;
+  }
+
+  UniformRandomNumberGenerator rng(mean_initial_values - 0.001,
+				   mean_initial_values + 0.001);
+  critic_network->initializeWeights(rng);
+
+  return true;
+}
+
+bool WorkingMemory::setBanks(int bank_count, const int* bank_sizes, const string* bank_types, double mean_initial_values) {
+  if (critic_network == NULL || use_actor || number_of_active_chunks > 0 ||
+      critic_network->getEngine() != LINEAR_ENGINE || bank_count < 1 ||
+      bank_sizes == NULL || bank_types == NULL)
+    return false;
+
+  int x, y;
+  int total = 0;
+
+  for (x = 0; x < bank_count; x++) {
+    if (bank_sizes[x] < 1)
+      return false;
+    total += bank_sizes[x];
+  }
+  if (total != number_of_chunks)
+    return false;
+
+  disposeBanks();
+  banks = new WMBank[bank_count];
+  number_of_banks = bank_count;
+
+  UniformRandomNumberGenerator rng(mean_initial_values - 0.001,
+				   mean_initial_values + 0.001);
+  ChunkFeatureVector cfvector(chunk_vector_size + 1, translate_chunk);
+  cfvector.clearVector();
+  cfvector.setValue(cfvector.getSize() - 1, WMTK_FV_MAX);
+
+  total = 0;
+  for (x = 0; x < bank_count; x++) {
+    WMBank& bank = banks[x];
+
+    bank.first_slot = total;
+    bank.size = bank_sizes[x];
+    bank.type = bank_types[x];
+    total += bank.size;
+
+    bank.or_features = new FeatureVector(chunk_vector_size + 1);
+    bank.aggregate =
+      new AggregateFeatureVector(state_vector_size, chunk_vector_size + 1,
+				 bank.size,
+				 aggregate_features->getCodingScheme(), false,
+				 aggregate_features->getHashBuckets());
+    bank.critic = new CriticNetwork(bank.aggregate->getSize(),
+				    LINEAR_ENGINE);
+    bank.critic->initializeWeights(rng);
+
+    // The critic starts from the empty bank in the current state.
+    for (y = 0; y < bank.size; y++)
+      chunk_features[bank.first_slot + y] = &cfvector;
+    bank.aggregate->updateFeatures(*state_features,
+				   chunk_features + bank.first_slot,
+				   *bank.or_features);
+    bank.critic->processVector(*bank.aggregate);
+    for (y = 0; y < bank.size; y++)
+      chunk_features[bank.first_slot + y] = NULL;
+  }
+
+  return true;
+}
+
+bool WorkingMemory::setShortlist(int size, double (*user_salience_function)(Chunk&, WorkingMemory&)) {
+  if (critic_network == NULL || size < 0)
+    return false;
+
+  shortlist_size = size;
+  salience_function = user_salience_function;
+
+  // The learned scorer keeps its weights while it is not in use.
+  if (shortlist_size > 0 && salience_function == NULL &&
+      candidate_scorer == NULL)
+    candidate_scorer = new CandidateScorer(state_vector_size,
+					   chunk_vector_size + 1);
+
+  return true;
+}
+
+int WorkingMemory::getShortlistSize() const {
+  return shortlist_size;
+}
+
+bool WorkingMemory::setLongTermMemory(LongTermMemory* store, int retrieval_count_value, void (*user_cue_function)(FeatureVector&, WorkingMemory&)) {
+  if (critic_network == NULL || retrieval_count_value < 0 ||
+      (store != NULL && store->getFeatureVectorSize() != chunk_vector_size))
+    return false;
+
+  long_term_memory = store;
+  retrieval_count = retrieval_count_value;
+  cue_function = user_cue_function;
+
+  // The cue is taken from the shortlist's scorer unless the user builds
+  // it.
+  if (long_term_memory != NULL && cue_function == NULL &&
+      candidate_scorer == NULL)
+    candidate_scorer = new CandidateScorer(state_vector_size,
+					   chunk_vector_size + 1);
+
+  return true;
+}
+
+LongTermMemory* WorkingMemory::getLongTermMemory() const {
+  return long_term_memory;
+}
+
+int WorkingMemory::storeLongTermChunk(Chunk& chunk) {
+  if (long_term_memory == NULL)
+    return -1;
+
+  ChunkFeatureVector features(chunk_vector_size, translate_chunk);
+  features.updateFeatures(chunk, *this);
+
+  return long_term_memory->storeChunk(chunk, features);
+}
+
+int WorkingMemory::retrieveCandidates(list<Chunk>& candidate_chunks) {
+  // The scorer's cue has a last element for the empty flag, which the
+  // stored vectors do not have.
+  vector<double> cue(chunk_vector_size + 1);
+  if (cue_function != NULL) {
+    FeatureVector user_cue(chunk_vector_size);
+    cue_function(user_cue, *this);
+    std::copy(user_cue.getValues(), user_cue.getValues() + chunk_vector_size,
+	      cue.begin());
+  }
+  else if (!candidate_scorer->buildCue(*state_features, &cue[0]))
+    return 0;
+
+  // Retrieve enough extra chunks to make up for those left out
+  int wanted = retrieval_count + number_of_active_chunks +
+    candidate_chunks.size();
+  vector<int> indices(wanted);
+  int found = long_term_memory->retrieve(&cue[0], wanted,
+					 &indices[0]);
+  int added = 0;
+  int x, y;
+  bool held;
+  list<Chunk>::iterator itr;
+
+  for (x = 0; x < found && added < retrieval_count; x++) {
+    Chunk chunk = long_term_memory->getChunk(indices[x]);
+    held = false;
+    for (y = 0; y < number_of_chunks && !held; y++)
+      held = (working_memory_store[y] != NULL &&
+	      working_memory_store[y]->getData() == chunk.getData() &&
+	      working_memory_store[y]->getType() == chunk.getType());
+    for (itr = candidate_chunks.begin();
+	 itr != candidate_chunks.end() && !held; itr++)
+      held = (itr->getData() == chunk.getData() &&
+	      itr->getType() == chunk.getType());
+    if (held)
+      continue;
+    candidate_chunks.push_back(chunk);
+    added++;
+  }
+
+  return added;
+}
+
+SELECTION_POLICY WorkingMemory::getSelectionPolicy() const {
+  return selection_policy;
+}
+
+bool WorkingMemory::setSelectionPolicy(SELECTION_POLICY policy, double softmax_gain) {
+  if (softmax_gain < 0.0)
+    return false;
+
+  selection_policy = policy;
+  selection_gain = softmax_gain;
+  return true;
+}
+
+int WorkingMemory::getNumberOfBanks() const {
+  return number_of_banks;
+}
+
+CriticNetwork* WorkingMemory::getBankCriticNetwork(int bank) const {
+  if (bank < 0 || bank >= number_of_banks)
+    return NULL;
+
+  return banks[bank].critic;
+}
+
 bool WorkingMemory::checkForTickCall(double tolerance) {
   if (tolerance < 0.0)
     tolerance = 0.1;
 
-  StateFeatureVector new_vector(state_features->getSize(), translate_state);
+  translateNextState();
+
+  // The sum stops once the distance is known to exceed the tolerance.
+  double total = next_state_features->squaredDistance(*state_features,
+						      tolerance * tolerance);
+  total = sqrt(total);
 
-  new_vector.updateFeatures(*this);
+  if (total <= tolerance)
+    return false;
 
+  return true;
+}
+
+void WorkingMemory::translateNextState() {
+  // The spare vector starts from the current state, so a translation
+  // function that changes only some features (see markStateChanged)
+  // can update it in place.
+  if (next_state_features == NULL)
+    next_state_features = new StateFeatureVector(*state_features);
+  else
+    *next_state_features = *state_features;
+
+  translateState(*next_state_features);
+}
+
+void WorkingMemory::translateState(StateFeatureVector& state_vector) {
+  translated_state = &state_vector;
+  state_vector.updateFeatures(*this);
+  translated_state = NULL;
+}
+
+bool WorkingMemory::markStateChanged(int first, int count) {
+  if (translated_state == NULL)
+    return false;
+
+  return translated_state->markChanged(first, count);
+}
+
+bool WorkingMemory::setStateChangeDetection(bool detect) {
+  if (critic_network == NULL)
+    return false;
+
+  state_features->setChangeDetection(detect);
+  if (next_state_features != NULL)
+    next_state_features->setChangeDetection(detect);
+  return true;
+}
+
+bool WorkingMemory::stateChanged(double tolerance) {
+  translateNextState();
+
+  if (tolerance < 0.0)
+    tolerance = 0.1;
+
+  const double* next = next_state_features->getValues();
+  const double* current = state_features->getValues();
+  double limit = tolerance * tolerance;
   double total = 0.0;
-  for (int x = 0; x < new_vector.getSize(); x++) {
-    double temp = (new_vector.getValue(x) - state_features->getValue(x)) *
-      (new_vector.getValue(x) - state_features->getValue(x));
-    total += temp;
+  double difference;
+  int x, y, first, count;
+
+  // When the changed ranges are known, only they are compared.
+  int ranges = next_state_features->getNumberOfChangedRanges();
+  bool known = (ranges >= 0);
+  if (!known) {
+    ranges = 1;
+    first = 0;
+    count = state_vector_size;
   }
-  total = sqrt(total);
 
-  if (total <= tolerance)
+  for (y = 0; y < ranges; y++) {
+    if (known)
+      next_state_features->getChangedRange(y, first, count);
+    if (change_tolerances.empty()) {
+      // The sum stops once the distance is known to exceed the tolerance.
+      for (x = first; x < first + count; x++) {
+	difference = next[x] - current[x];
+	total += difference * difference;
+	if (total > limit)
+	  return true;
+      }
+    }
+    else {
+      // Stop at the first feature that has moved by more than its
+      // tolerance
+      for (x = first; x < first + count; x++)
+	if (fabs(next[x] - current[x]) > change_tolerances[x])
+	  return true;
+    }
+  }
+
+  return false;
+}
+
+bool WorkingMemory::setChangeTolerances(const double* tolerances) {
+  if (critic_network == NULL)
     return false;
 
+  if (tolerances == NULL) {
+    change_tolerances.clear();
+    return true;
+  }
+
+  for (int x = 0; x < state_vector_size; x++)
+    if (tolerances[x] < 0.0)
+      return false;
+
+  change_tolerances.assign(tolerances, tolerances + state_vector_size);
   return true;
 }
@@ -63,22 +63,38 @@
 #define WMTK_WORKING_MEMORY_H
 
 #include <list>
+#include <vector>
 
 #include <Chunk.h>
 #include <StateFeatureVector.h>
 #include <AggregateFeatureVector.h>
+#include <CriticNetwork.h>
 
 class ActorNetwork;
-class CriticNetwork;
+class CandidateScorer;
 class FeatureVector;
 class ChunkFeatureVector;
+class LongTermMemory;
 class UniformRandomNumberGenerator;
+struct WMCombo;
+struct WMBank;
 
 #define WMTK_MAX_CHUNKS	200
 #define MEMORY_EXPLORATION_PERCENTAGE 0.05
+#define MEMORY_SOFTMAX_GAIN 5.0
 
 using namespace std;
 
+// Enumeration of the ways of choosing the contents of working memory
+// from the critic's values: epsilon-greedy (the best contents, or random
+// contents exploration_percentage of the time), or softmax (contents
+// drawn with probability proportional to the exponential of the gain
+// times their value).
+enum SELECTION_POLICY {
+  EPSILON_GREEDY_SELECTION,
+  SOFTMAX_SELECTION
+};
+
 class WorkingMemory {
 
  public:
@@ -97,10 +113,25 @@ class WorkingMemory {
   // respectively.
   //
   // The using_actor flag tells the working memory system whether to use
-  // an actor network for selecting chunks for storage.
+  // an actor network for selecting chunks for storage. The actor fills
+  // the slots one at a time with a draw from a softmax over the
+  // candidates, so a time step costs one forward pass per candidate
+  // rather than a critic evaluation for every assignment of candidates
+  // to slots. (The exploration percentage is not used by the actor.)
   // The using_or_code flag tells the working memory system whether to
   // evaluate the “OR” of all chunks or just take them individually when
   // selecting them for storage.
+  //
+  // The coding_scheme decides how the state and chunk vectors are
+  // combined for the critic (see AggregateFeatureVector). Each
+  // WorkingMemory object has its own.
+  //
+  // The HASHED_CONJ scheme hashes the conjunctions of the state and
+  // chunk features into hash_buckets buckets, so the size of the critic
+  // does not depend on the number or size of the chunks.
+  //
+  // The critic starts as a LINEAR_ENGINE network; see setCriticEngine
+  // for the others.
   WorkingMemory(int wm_size,
 		int state_feature_vector_size,
 		int chunk_feature_vector_size,
@@ -112,7 +143,9 @@ class WorkingMemory {
 		void (*user_delete_function)(Chunk&),
 		bool use_actor,
 		OR_CODE or_code,
-		double mean_initial_values = 2.0);
+		double mean_initial_values = 2.0,
+		CODING_SCHEME coding_scheme = WM_CONJ,
+		int hash_buckets = 0);
 
   // Destructor
   ~WorkingMemory();
@@ -123,6 +156,18 @@ class WorkingMemory {
   // Assignment Operator
   WorkingMemory& operator=(const WorkingMemory&);
 
+  // Exchanges the contents of this working memory with those of the provided
+  // one, without copying or allocating.
+  void swap(WorkingMemory&);
+
+#if __cplusplus >= 201103L
+  // Move-Constructor and Move-Assignment
+  // Take over the contents of the source, which is left valid but
+  // unspecified.
+  WorkingMemory(WorkingMemory&&) noexcept;
+  WorkingMemory& operator=(WorkingMemory&&) noexcept;
+#endif
+
   // Returns the total number of chunks that the working memory system
   // can hold at any one time.
   int getWorkingMemorySize() const;
@@ -161,7 +206,8 @@ class WorkingMemory {
   // the two state vectors. The provided tolerance will be used to
   // gauge the difference being significant. This function can be used
   // to gauge when to call tickEpisodeClock (it might not need to be
-  // called if this function returns false.)
+  // called if this function returns false; tickOnChange does both
+  // without translating the state twice.)
   bool checkForTickCall(double tolerance);
 
   // This function performs several different critical functions. First,
@@ -175,6 +221,43 @@ class WorkingMemory {
   // increment if there was a problem while processing working memory.
   int tickEpisodeClock(list<Chunk>& candidate_chunks, bool learn = true);
 
+  // Event-driven version of tickEpisodeClock. The state is translated
+  // once and compared with the last one: by the Euclidean distance
+  // against the tolerance (as in checkForTickCall), or, if tolerances
+  // have been set for the state features (see setChangeTolerances), by
+  // the change in each feature against its own tolerance. If the change
+  // is significant or there are candidate chunks, the tick proceeds as
+  // tickEpisodeClock does with the translated state. Otherwise the
+  // search is skipped: the contents and state vector are kept, and the
+  // critics take the elapsed time step from the current contents to the
+  // same contents, learning from the reward as usual (there is no
+  // exploration and the actor does not learn on such a step). Either
+  // way the clock is incremented and its new value returned.
+  int tickOnChange(list<Chunk>& candidate_chunks,
+		   double tolerance,
+		   bool learn = true);
+
+  // Sets a tolerance for each state feature (state vector size values,
+  // none negative) for tickOnChange, or clears them if tolerances is
+  // NULL. Returns true on success and false otherwise.
+  bool setChangeTolerances(const double* tolerances);
+
+  // Records, from within the state translation function, that it changed
+  // count state features from first and left the rest of the state
+  // vector as it was (so it must not clear the vector). When the
+  // function marks its changes, the state vector's copies in the critic
+  // input are refreshed only there, and for the concatenated code the
+  // critic's value for the state is adjusted only there while its
+  // weights are unchanged. Returns false if called outside the
+  // translation function or if the range does not fit.
+  bool markStateChanged(int first, int count);
+
+  // Turns on or off the detection of the changed state features by
+  // comparison with the previous state vector, which has the same effect
+  // as marking them for translation functions that do not. Returns true
+  // on success and false otherwise.
+  bool setStateChangeDetection(bool detect);
+
   // Checks to see if the WorkingMemory class is using an actor network
   // to process chunks.
   bool isUsingActor() const;
@@ -202,6 +285,29 @@ class WorkingMemory {
   // success and false otherwise.
   bool setExplorationPercentage(double val);
 
+  // Returns the policy used to choose the contents of working memory.
+  SELECTION_POLICY getSelectionPolicy() const;
+
+  // Sets the policy used to choose the contents of working memory, and
+  // the gain for the softmax policy. When the critic's value is a sum of
+  // one term for each slot (the CONCAT scheme with NO_OR and a linear
+  // critic, or tied slots without pair weights), the softmax draw is
+  // made without valuing every combination: the sum of the weights of
+  // the combinations is computed by dynamic programming over the
+  // candidates and the sets of filled slots, and the combination is
+  // drawn backward through it. Returns true on success and false
+  // otherwise.
+  bool setSelectionPolicy(SELECTION_POLICY policy,
+			  double softmax_gain = MEMORY_SOFTMAX_GAIN);
+
+  // Returns the fraction of the active conjunctions of the current
+  // contents that share a hash bucket with another one (zero when the
+  // code is not hashed).
+  double getHashCollisionRate() const;
+
+  // Returns the coding scheme used for the critic's input.
+  CODING_SCHEME getCodingScheme() const;
+
   // Returns a pointer to the CriticNetwork object that the
   // WorkingMemory object has created for learning the value of its
   // working memory contents.
@@ -212,6 +318,111 @@ class WorkingMemory {
   // memory system.
   ActorNetwork*	getActorNetwork() const;
 
+  // Replaces the critic with a new one computed by the given engine,
+  // with initial weights near mean_initial_values:
+  //
+  // LINEAR_ENGINE and NNET_ENGINE weigh the code of the coding scheme
+  // linearly.
+  //
+  // LOW_RANK_ENGINE keeps the WM_CONJ and COMPLETE_CONJ codes from being
+  // expanded; it keeps a rank size factored (CP) model of the
+  // conjunctive weights over the concatenated features instead (see
+  // LowRankTDCritic).
+  //
+  // HIDDEN_ENGINE gives the critic a layer of size hidden units with
+  // the given activation function (see HiddenTDCritic), which can learn
+  // the interactions between the state and the chunks from the CONCAT
+  // scheme without a conjunctive code.
+  //
+  // TIED_ENGINE makes the chunk slots of the CONCAT code share the
+  // critic's chunk weights (and pair weights for TIED_SLOTS_AND_PAIRS,
+  // see TiedTDCritic), so that a chunk is worth the same in any slot.
+  // The value of each candidate (and pair of candidates) is then
+  // computed once per time step, and only one ordering of each set of
+  // contents is searched.
+  //
+  // The size must be positive for LOW_RANK_ENGINE and HIDDEN_ENGINE and
+  // zero otherwise. The engine can only be set while the memory is
+  // empty and before banks are set. Returns true on success, and false
+  // (leaving the critic unchanged) if the engine does not support the
+  // coding scheme or the other arguments.
+  bool setCriticEngine(CRITIC_ENGINE engine,
+		       int size = 0,
+		       HIDDEN_ACTIVATION hidden_activation = TANH_ACTIVATION,
+		       SLOT_TYING slot_tying = TIED_SLOTS,
+		       double mean_initial_values = 2.0);
+
+  // Splits the slots into number_of_banks banks of the given sizes
+  // (which must add up to the working memory size), in order. Each bank
+  // takes only the candidate chunks of its type (those of any type if
+  // its type is the empty string); a candidate goes to the first bank
+  // that takes it, and those that no bank takes are dropped. Each bank
+  // has its own linear critic over the state and the contents of its
+  // slots, with initial weights near mean_initial_values, and is
+  // searched on its own, so a time step costs the sum of the searches
+  // of the banks rather than a search of every assignment to all of the
+  // slots. The reward is shared by the banks. The main critic is left
+  // unused once banks are set, and saveNetwork and loadNetwork then
+  // cover only the critics of the banks. Banks cannot be used with the
+  // actor network or with a critic engine other than LINEAR_ENGINE, and
+  // can only be set up while the memory is empty. Returns true on
+  // success and false otherwise.
+  bool setBanks(int number_of_banks,
+		const int* bank_sizes,
+		const string* bank_types,
+		double mean_initial_values = 2.0);
+
+  // Limits the search to the size best-scoring new candidates (of each
+  // bank) and the chunks already in memory, so that its cost depends on
+  // size rather than on the number of candidates; zero searches every
+  // candidate. The candidates are scored by the user_salience_function
+  // if one is given (higher is better). Otherwise they are scored by a
+  // linear model of the state and chunk vectors (see CandidateScorer),
+  // which learns the critic's marginal value of including a chunk: the
+  // value of the best searched combination holding the chunk less that
+  // of the best one without it. The shortlist is not used with the actor
+  // network. Returns true on success and false otherwise.
+  bool setShortlist(int size,
+		    double (*user_salience_function)(Chunk&, WorkingMemory&)
+		    = NULL);
+
+  // Returns the size of the shortlist (zero if it is not used).
+  int getShortlistSize() const;
+
+  // Attaches a long-term memory (NULL detaches it), from which
+  // retrieval_count chunks are added to the candidates at each time step:
+  // those whose feature vectors have the largest dot products with a cue
+  // built from the state, leaving out the chunks already in memory or in
+  // the candidate list (the same data and type). The cue is made by the
+  // user_cue_function if one is given, from a vector of the chunk vector
+  // size; otherwise it is taken from the linear model of the shortlist
+  // (see setShortlist), so that the chunks retrieved are the ones that
+  // model would score best, and the model learns from the searches as
+  // it does for the shortlist. The store's feature vectors must have the
+  // chunk vector size (see storeLongTermChunk). The store is not copied
+  // with the WorkingMemory object and is not deleted by it. Retrieved
+  // chunks share their data with the store, so they are never passed to
+  // the delete_chunk function (whether they are passed over or later
+  // removed from memory). Returns true on success and false otherwise.
+  bool setLongTermMemory(LongTermMemory* store,
+			 int retrieval_count,
+			 void (*user_cue_function)(FeatureVector&,
+						   WorkingMemory&) = NULL);
+
+  // Returns the attached long-term memory (NULL if there is none).
+  LongTermMemory* getLongTermMemory() const;
+
+  // Stores the chunk in the attached long-term memory with its feature
+  // vector. Returns the index of the stored chunk, or -1 on failure.
+  int storeLongTermChunk(Chunk& chunk);
+
+  // Returns the number of banks (zero if the slots are not split).
+  int getNumberOfBanks() const;
+
+  // Returns a pointer to the CriticNetwork object of the given bank
+  // (NULL if there is no such bank).
+  CriticNetwork* getBankCriticNetwork(int bank) const;
+
  private:
 
   // The size of the state vector.
@@ -223,6 +434,10 @@ class WorkingMemory {
   // Array of chunks stored in working memory.
   Chunk** working_memory_store;
 
+  // Whether the chunk in each slot came from the long-term memory (and so
+  // is not disposed of with delete_chunk).
+  bool* long_term_slots;
+
   // Total size of the working memory (maximum number of chunks that can
   // be stored in working_memory_store.)
   int number_of_chunks;
@@ -287,10 +502,112 @@ class WorkingMemory {
   // critic network. (5% by default.)
   double exploration_percentage;
 
+  // Policy used to choose the contents of working memory, and the gain
+  // of the softmax policy.
+  SELECTION_POLICY selection_policy;
+  double selection_gain;
+
+  // Banks of slots, each searched on its own with its own critic (NULL
+  // if the slots are not split).
+  WMBank* banks;
+
+  // Number of banks (zero if the slots are not split).
+  int number_of_banks;
+
+  // Number of new candidates that go on to the search (zero for all of
+  // them).
+  int shortlist_size;
+
+  // User function for scoring candidates for the shortlist (NULL to use
+  // the candidate_scorer).
+  double (*salience_function)(Chunk&, WorkingMemory&);
+
+  // Learned model for scoring candidates for the shortlist.
+  CandidateScorer* candidate_scorer;
+
+  // Long-term memory from which candidates are retrieved (NULL if there
+  // is none; owned by the user), the number retrieved at each time step,
+  // and the user function for building the cue (NULL to use the
+  // candidate_scorer).
+  LongTermMemory* long_term_memory;
+  int retrieval_count;
+  void (*cue_function)(FeatureVector&, WorkingMemory&);
+
+  // Spare state vector into which the state is translated to test for a
+  // change (NULL until needed), and the tolerance of each state feature
+  // for tickOnChange (empty to use the Euclidean distance).
+  StateFeatureVector* next_state_features;
+  vector<double> change_tolerances;
+
+  // State vector being translated (NULL outside the translation
+  // function).
+  StateFeatureVector* translated_state;
+
   // Contructor and Destructor utility functions
   void init();
   void dispose();
   void copy(const WorkingMemory&, WorkingMemory&);
+  void disposeBanks();
+
+  // Returns the banks and their number; without banks, the whole memory
+  // is described as a single bank in whole.
+  WMBank* listBanks(WMBank& whole, int& count) const;
+
+  // Values every assignment of the given chunks (translated in
+  // translations) to the slots of the bank and returns the chosen one.
+  // Fills marginals with the marginal value of each chunk unless it is
+  // NULL.
+  WMCombo* searchContents(WMBank& bank,
+			  vector<Chunk*>& chunks,
+			  vector<ChunkFeatureVector>& translations,
+			  ChunkFeatureVector& empty,
+			  double* marginals);
+
+  // Draws contents for the bank from the softmax over the combinations
+  // by dynamic programming, when the critic's value is a sum of one term
+  // per slot. Returns NULL if it is not (or the draw cannot be made).
+  WMCombo* sampleContents(WMBank& bank,
+			  vector<Chunk*>& chunks,
+			  vector<ChunkFeatureVector>& translations,
+			  ChunkFeatureVector& empty);
+
+  // Takes the time step of tickEpisodeClock once the state vector has
+  // been updated.
+  int advanceEpisode(list<Chunk>& candidate_chunks, bool learn);
+
+  // Translates the current state into next_state_features.
+  void translateNextState();
+
+  // Translates the current state into the given state vector.
+  void translateState(StateFeatureVector& state_vector);
+
+  // Translates the current state into next_state_features and returns
+  // true if it differs significantly from the state vector.
+  bool stateChanged(double tolerance);
+
+  // Adds copies of the long-term chunks that best match the cue to the
+  // candidate list. Returns the number of chunks added (at the end of the
+  // list).
+  int retrieveCandidates(list<Chunk>& candidate_chunks);
+
+  // Disposes of all but the shortlist_size best-scoring of the first
+  // count chunks (the new candidates) and their translations (and their
+  // flags in long_term, which mark the chunks not to be passed to
+  // delete_chunk).
+  void shortlistCandidates(int count,
+			   vector<Chunk*>& chunks,
+			   vector<ChunkFeatureVector>& translations,
+			   vector<bool>& long_term);
+
+  // Points the chunk_features of the given slots at the translations of
+  // the given contents (the empty vector for the empty slots) and
+  // rebuilds the OR vector of those slots. Returns the number of chunks.
+  int assignChunkFeatures(const int* contents,
+			  int first_slot,
+			  int slots,
+			  FeatureVector& or_features,
+			  vector<ChunkFeatureVector>& translations,
+			  ChunkFeatureVector& empty);
 
 };
 
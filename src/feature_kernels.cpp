@@ -0,0 +1,316 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+/******************************************************************************
+ * feature_kernels.cpp
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ *****************************************************************************/
+
+#include <feature_kernels.h>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Elements visited between checks of the distance limit.
+#define DISTANCE_BLOCK 16
+
+// Constants of the exponential approximation: x is split into k ln 2 + r
+// with |r| <= ln(2)/2 (k rounded by the 1.5 * 2^52 trick, which leaves k
+// in the low bits of the sum), e^r is a Taylor polynomial and 2^k is
+// built in the exponent bits.
+#define EXP_LOWEST -708.0
+#define EXP_LOG2E 1.4426950408889634
+#define EXP_LN2_HIGH 6.93145751953125e-1
+#define EXP_LN2_LOW 1.42860682030941723212e-6
+#define EXP_ROUNDER 6755399441055744.0
+#define EXP_ROUNDER_BITS 0x4338000000000000ULL
+
+static const double exp_terms[12] = {
+  1.0, 1.0, 1.0 / 2.0, 1.0 / 6.0, 1.0 / 24.0, 1.0 / 120.0, 1.0 / 720.0,
+  1.0 / 5040.0, 1.0 / 40320.0, 1.0 / 362880.0, 1.0 / 3628800.0,
+  1.0 / 39916800.0
+};
+
+// Returns e^x for x <= 0 (the scalar version of the loop in
+// gaussianValues, step for step).
+static double approximateExp(double x) {
+  double k, r, p;
+  unsigned long long bits;
+  int y;
+
+  if (!(x >= EXP_LOWEST))
+    return 0.0;
+
+  k = (x * EXP_LOG2E) + EXP_ROUNDER;
+  memcpy(&bits, &k, sizeof(bits));
+  k -= EXP_ROUNDER;
+  r = (x - (k * EXP_LN2_HIGH)) - (k * EXP_LN2_LOW);
+
+  p = exp_terms[11];
+  for (y = 10; y >= 0; y--)
+    p = (p * r) + exp_terms[y];
+
+  bits = (bits - EXP_ROUNDER_BITS + 1023) << 52;
+  memcpy(&k, &bits, sizeof(k));
+  return p * k;
+}
+
+void fillValues(double* dest, int size, double value) {
+  int x = 0;
+
+#ifdef __SSE2__
+  __m128d v = _mm_set1_pd(value);
+  for (; x + 2 <= size; x += 2)
+    _mm_storeu_pd(dest + x, v);
+#endif
+
+  for (; x < size; x++)
+    dest[x] = value;
+}
+
+void copyValues(double* dest, const double* source, int size) {
+  if (size > 0)
+    memcpy(dest, source, size * sizeof(double));
+}
+
+void clampValues(double* dest, int size, double low, double high) {
+  int x = 0;
+
+#ifdef __SSE2__
+  // With the bound first, maxpd and minpd pass a NaN element through.
+  __m128d l = _mm_set1_pd(low);
+  __m128d h = _mm_set1_pd(high);
+  for (; x + 2 <= size; x += 2)
+    _mm_storeu_pd(dest + x,
+		  _mm_min_pd(h, _mm_max_pd(l, _mm_loadu_pd(dest + x))));
+#endif
+
+  for (; x < size; x++) {
+    if (low > dest[x])
+      dest[x] = low;
+    if (high < dest[x])
+      dest[x] = high;
+  }
+}
+
+void maxValues(double* dest, const double* source, int size) {
+  int x = 0;
+
+#ifdef __SSE2__
+  // maxpd returns its second operand unless the first is larger, which
+  // keeps dest where the elements are equal (or source is NaN).
+  for (; x + 2 <= size; x += 2)
+    _mm_storeu_pd(dest + x, _mm_max_pd(_mm_loadu_pd(source + x),
+				       _mm_loadu_pd(dest + x)));
+#endif
+
+  for (; x < size; x++)
+    if (source[x] > dest[x])
+      dest[x] = source[x];
+}
+
+void noisyOrValues(double* dest, const double* source, int size) {
+  int x = 0;
+
+#ifdef __SSE2__
+  __m128d one = _mm_set1_pd(1.0);
+  for (; x + 2 <= size; x += 2)
+    _mm_storeu_pd(dest + x,
+		  _mm_sub_pd(one,
+			     _mm_mul_pd(_mm_sub_pd(one, _mm_loadu_pd(dest + x)),
+					_mm_sub_pd(one,
+						   _mm_loadu_pd(source + x)))));
+#endif
+
+  for (; x < size; x++)
+    dest[x] = 1.0 - ((1.0 - dest[x]) * (1.0 - source[x]));
+}
+
+double squaredDistance(const double* a, const double* b, int size, double limit) {
+  int x = 0;
+  int end;
+  double total = 0.0;
+  double d;
+
+  while (x < size) {
+    end = x + DISTANCE_BLOCK;
+    if (end > size)
+      end = size;
+
+#ifdef __SSE2__
+    __m128d sum = _mm_setzero_pd();
+    __m128d diff;
+    double lanes[2];
+    for (; x + 2 <= end; x += 2) {
+      diff = _mm_sub_pd(_mm_loadu_pd(a + x), _mm_loadu_pd(b + x));
+      sum = _mm_add_pd(sum, _mm_mul_pd(diff, diff));
+    }
+    _mm_storeu_pd(lanes, sum);
+    total += lanes[0] + lanes[1];
+#endif
+
+    for (; x < end; x++) {
+      d = a[x] - b[x];
+      total += d * d;
+    }
+
+    if (total > limit)
+      return total;
+  }
+
+  return total;
+}
+
+int compareValues(const double* a, const double* b, int size) {
+  int x = 0;
+
+#ifdef __SSE2__
+  // Skip pairs of equal elements; the first difference is resolved
+  // below.
+  for (; x + 2 <= size; x += 2)
+    if (_mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(a + x),
+				     _mm_loadu_pd(b + x))) != 3)
+      break;
+#endif
+
+  for (; x < size; x++) {
+    if (a[x] > b[x])
+      return 1;
+    else if (a[x] < b[x])
+      return -1;
+  }
+
+  return 0;
+}
+
+void thresholdValues(double* dest, const double* thresholds, int size, double value, double low, double high) {
+  int x = 0;
+
+#ifdef __SSE2__
+  __m128d v = _mm_set1_pd(value);
+  __m128d l = _mm_set1_pd(low);
+  __m128d h = _mm_set1_pd(high);
+  __m128d mask;
+  for (; x + 2 <= size; x += 2) {
+    mask = _mm_cmpge_pd(v, _mm_loadu_pd(thresholds + x));
+    _mm_storeu_pd(dest + x, _mm_or_pd(_mm_and_pd(mask, h),
+				      _mm_andnot_pd(mask, l)));
+  }
+#endif
+
+  for (; x < size; x++)
+    dest[x] = (value >= thresholds[x]) ? high : low;
+}
+
+void bandValues(double* dest, const double* lower, const double* upper, int size, double value, double low, double high) {
+  int x = 0;
+
+#ifdef __SSE2__
+  __m128d v = _mm_set1_pd(value);
+  __m128d l = _mm_set1_pd(low);
+  __m128d h = _mm_set1_pd(high);
+  __m128d mask;
+  for (; x + 2 <= size; x += 2) {
+    mask = _mm_and_pd(_mm_cmpge_pd(v, _mm_loadu_pd(lower + x)),
+		      _mm_cmplt_pd(v, _mm_loadu_pd(upper + x)));
+    _mm_storeu_pd(dest + x, _mm_or_pd(_mm_and_pd(mask, h),
+				      _mm_andnot_pd(mask, l)));
+  }
+#endif
+
+  for (; x < size; x++)
+    dest[x] = (value >= lower[x] && value < upper[x]) ? high : low;
+}
+
+void gaussianValues(double* dest, const double* means, int size, double value, double variance, double scale, double offset) {
+  int x = 0;
+  double d;
+
+#ifdef __SSE2__
+  __m128d v = _mm_set1_pd(value);
+  __m128d var = _mm_set1_pd(variance);
+  __m128d lowest = _mm_set1_pd(EXP_LOWEST);
+  __m128d log2e = _mm_set1_pd(EXP_LOG2E);
+  __m128d rounder = _mm_set1_pd(EXP_ROUNDER);
+  __m128d ln2_high = _mm_set1_pd(EXP_LN2_HIGH);
+  __m128d ln2_low = _mm_set1_pd(EXP_LN2_LOW);
+  __m128d s = _mm_set1_pd(scale);
+  __m128d o = _mm_set1_pd(offset);
+  __m128i bias = _mm_set1_epi64x((long long) (1023 - EXP_ROUNDER_BITS));
+  __m128d diff, e, k, r, p, in_range;
+  __m128i bits;
+  int y;
+  for (; x + 2 <= size; x += 2) {
+    diff = _mm_sub_pd(v, _mm_loadu_pd(means + x));
+    e = _mm_div_pd(_mm_sub_pd(_mm_setzero_pd(), _mm_mul_pd(diff, diff)), var);
+    in_range = _mm_cmpge_pd(e, lowest);
+    e = _mm_and_pd(in_range, e);
+
+    k = _mm_add_pd(_mm_mul_pd(e, log2e), rounder);
+    bits = _mm_castpd_si128(k);
+    k = _mm_sub_pd(k, rounder);
+    r = _mm_sub_pd(_mm_sub_pd(e, _mm_mul_pd(k, ln2_high)),
+		   _mm_mul_pd(k, ln2_low));
+
+    p = _mm_set1_pd(exp_terms[11]);
+    for (y = 10; y >= 0; y--)
+      p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(exp_terms[y]));
+
+    bits = _mm_slli_epi64(_mm_add_epi64(bits, bias), 52);
+    p = _mm_and_pd(in_range, _mm_mul_pd(p, _mm_castsi128_pd(bits)));
+    _mm_storeu_pd(dest + x, _mm_add_pd(_mm_mul_pd(s, p), o));
+  }
+#endif
+
+  for (; x < size; x++) {
+    d = value - means[x];
+    dest[x] = (scale * approximateExp(-(d * d) / variance)) + offset;
+  }
+}
+
+void dotProducts(const double* rows, int count, int size, const double* vector, double* results) {
+  int r, x;
+  double total;
+
+  for (r = 0; r < count; r++, rows += size) {
+    x = 0;
+    total = 0.0;
+
+#ifdef __SSE2__
+    __m128d sum = _mm_setzero_pd();
+    double lanes[2];
+    for (; x + 2 <= size; x += 2)
+      sum = _mm_add_pd(sum, _mm_mul_pd(_mm_loadu_pd(rows + x),
+				       _mm_loadu_pd(vector + x)));
+    _mm_storeu_pd(lanes, sum);
+    total = lanes[0] + lanes[1];
+#endif
+
+    for (; x < size; x++)
+      total += rows[x] * vector[x];
+
+    results[r] = total;
+  }
+}
@@ -0,0 +1,91 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+/******************************************************************************
+ * feature_kernels.h
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * Bulk operations on the contiguous storage of feature vectors, used by
+ * the FeatureVector family and the WorkingMemory class in place of
+ * element-by-element accessors. When compiled for a target with SSE2,
+ * the loops process two doubles per instruction; otherwise they are
+ * plain loops. Both versions give the same results, except that the
+ * squared distance may be summed in a different order.
+ *
+ *****************************************************************************/
+
+#ifndef FEATURE_KERNELS_H
+#define FEATURE_KERNELS_H
+
+// Sets size elements of dest to value.
+void fillValues(double* dest, int size, double value);
+
+// Copies size elements of source into dest (which must not overlap).
+void copyValues(double* dest, const double* source, int size);
+
+// Limits each element of dest to [low, high] (NaNs are left alone).
+void clampValues(double* dest, int size, double low, double high);
+
+// Replaces each element of dest with the larger of it and the
+// corresponding element of source.
+void maxValues(double* dest, const double* source, int size);
+
+// Replaces each element a of dest with 1 - (1 - a)(1 - b), where b is
+// the corresponding element of source: the noisy "OR" of values in
+// [0,1], computed without division.
+void noisyOrValues(double* dest, const double* source, int size);
+
+// Returns the squared Euclidean distance between a and b. The sum is
+// abandoned as soon as it exceeds limit, in which case some value
+// above limit is returned.
+double squaredDistance(const double* a, const double* b, int size,
+		       double limit);
+
+// Compares a and b element by element, in order: returns 1 at the
+// first element where a is larger, -1 at the first where it is
+// smaller, and 0 if they are equal.
+int compareValues(const double* a, const double* b, int size);
+
+// Sets each element of dest to high where value >= thresholds[x] and to
+// low elsewhere (the thermometer code).
+void thresholdValues(double* dest, const double* thresholds, int size,
+		     double value, double low, double high);
+
+// Sets each element of dest to high where lower[x] <= value < upper[x]
+// and to low elsewhere (the speedometer code).
+void bandValues(double* dest, const double* lower, const double* upper,
+		int size, double value, double low, double high);
+
+// Sets each element of dest to scale * e^(-(value - means[x])^2 /
+// variance) + offset (the gaussian coarse code). The exponential is a
+// polynomial approximation with a relative error below 1e-14; results
+// under e^-708 are flushed to zero.
+void gaussianValues(double* dest, const double* means, int size,
+		    double value, double variance, double scale,
+		    double offset);
+
+// Sets results[r] to the dot product of vector with row r of the count
+// by size matrix rows (stored row after row).
+void dotProducts(const double* rows, int count, int size,
+		 const double* vector, double* results);
+
+#endif
@@ -59,200 +59,102 @@ void FullForwardProjection::init() {
 }
 
 void FullForwardProjection::dispose() {
+  if (weights != NULL)
+    delete [] weights;
+  if (d_weights != NULL)
+    delete [] d_weights;
+  if (w_transpose != NULL)
+    delete [] w_transpose;
+  storage.release();
+  init();
+}
+
+// Points the matrices and work vectors at their places in the storage
+// arena. The arena holds, in order: weights, d_weights, w_transpose,
+// work_vec1, work_vec2, work_vec3, work_vec4 and work_vec5.
+bool FullForwardProjection::layoutStorage() {
+  int from_size = getFromSize();
+  int to_size = getToSize();
+  int in_dims = getToLayer()->getNumberOfInputDimensions();
+  int matrix = from_size * to_size;
   int x;
-  if (weights != NULL) {
-    for (x = 0; x < getFromSize(); x++)
-      delete [] weights[x];
 
-    delete [] weights;
-  }
-  if (d_weights != NULL) {
-    for (x = 0; x < getFromSize(); x++)
-      delete [] d_weights[x];
+  if (storage.getLength() != (size_t) ((3 * matrix) + (2 * to_size) +
+					(2 * in_dims) + from_size))
+    return false;
 
-    delete [] d_weights;
-  }
-  if (w_transpose != NULL) {
-    for (x = 0; x < getToSize(); x++)
-      delete [] w_transpose[x];
+  weights = new double*[from_size];
+  d_weights = new double*[from_size];
+  w_transpose = new double*[to_size];
 
-    delete [] w_transpose;
+  for (x = 0; x < from_size; x++) {
+    weights[x] = storage.at(x * to_size);
+    d_weights[x] = storage.at(matrix + (x * to_size));
   }
-  if (work_vec1 != NULL)
-    delete [] work_vec1;
-  if (work_vec2 != NULL)
-    delete [] work_vec2;
-  if (work_vec3 != NULL)
-    delete [] work_vec3;
-  if (work_vec4 != NULL)
-    delete [] work_vec4;
-  if (work_vec5 != NULL)
-    delete [] work_vec5;
+  for (x = 0; x < to_size; x++)
+    w_transpose[x] = storage.at((2 * matrix) + (x * from_size));
+
+  work_vec1 = storage.at(3 * matrix);
+  work_vec2 = work_vec1 + to_size;
+  work_vec3 = work_vec2 + to_size;
+  work_vec4 = work_vec3 + in_dims;
+  work_vec5 = work_vec4 + in_dims;
+
+  return true;
 }
 
 FullForwardProjection::~FullForwardProjection() {
   dispose();
 }
 
-FullForwardProjection::FullForwardProjection(const FullForwardProjection& L) : Projection(L) {
-  int x,y;
+FullForwardProjection::FullForwardProjection(const FullForwardProjection& L) : Projection(L), storage(L.storage) {
   init();
   min_w = L.min_w;
   max_w = L.max_w;
   w_bound = L.w_bound;
 
-  if (L.weights != NULL) {
-    weights = new double*[getFromSize()];
-    for (x = 0; x < getFromSize(); x++) {
-      weights[x] = new double[getToSize()];
-      for (y = 0; y < getToSize(); y++)
-	weights[x][y] = L.weights[x][y];
-    }
-  }
-  if (L.d_weights != NULL) {
-    d_weights = new double*[getFromSize()];
-    for (x = 0; x < getFromSize(); x++) {
-      d_weights[x] = new double[getToSize()];
-      for (y = 0; y < getToSize(); y++)
-	d_weights[x][y] = L.d_weights[x][y];
-    }
-  }
-  if (L.w_transpose != NULL) {
-    w_transpose = new double*[getToSize()];
-    for (x = 0; x < getToSize(); x++) {
-      w_transpose[x] = new double[getFromSize()];
-      for (y = 0; y < getFromSize(); y++)
-	w_transpose[x][y] = L.w_transpose[x][y];
-    }
-  }
-  if (L.work_vec1 != NULL) {
-    work_vec1 = new double[getToSize()];
-    for (x = 0; x < getToSize(); x++)
-      work_vec1[x] = L.work_vec1[x];
-  }
-  if (L.work_vec2 != NULL) {
-    work_vec2 = new double[getToSize()];
-    for (x = 0; x < getToSize(); x++)
-      work_vec2[x] = L.work_vec2[x];
-  }
-  if (L.work_vec3 != NULL) {
-    work_vec3 = new double[getToLayer()->getNumberOfInputDimensions()];
-    for (x = 0; x < getToLayer()->getNumberOfInputDimensions(); x++)
-      work_vec3[x] = L.work_vec3[x];
-  }
-  if (L.work_vec4 != NULL) {
-    work_vec4 = new double[getToLayer()->getNumberOfInputDimensions()];
-    for (x = 0; x < getToLayer()->getNumberOfInputDimensions(); x++)
-      work_vec4[x] = L.work_vec4[x];
-  }
-  if (L.work_vec5 != NULL) {
-    work_vec5 = new double[getFromSize()];
-    for (x = 0; x < getFromSize(); x++)
-      work_vec5[x] = L.work_vec5[x];
-  }
+  if (L.weights != NULL)
+    layoutStorage();
 }
 
 
 
 FullForwardProjection& FullForwardProjection::operator=(const FullForwardProjection& Rhs) {
-  int x, y;
   if (this != &Rhs) {
     Projection::operator=(Rhs);
-    dispose();
+    if (weights != NULL)
+      delete [] weights;
+    if (d_weights != NULL)
+      delete [] d_weights;
+    if (w_transpose != NULL)
+      delete [] w_transpose;
+    init();
     min_w = Rhs.min_w;
     max_w = Rhs.max_w;
     w_bound = Rhs.w_bound;
 
-    if (Rhs.weights != NULL) {
-      weights = new double*[getFromSize()];
-      for (x = 0; x < getFromSize(); x++) {
-	weights[x] = new double[getToSize()];
-	for (y = 0; y < getToSize(); y++)
-	  weights[x][y] = Rhs.weights[x][y];
-      }
-    }
-    if (Rhs.d_weights != NULL) {
-      d_weights = new double*[getFromSize()];
-      for (x = 0; x < getFromSize(); x++) {
-	d_weights[x] = new double[getToSize()];
-	for (y = 0; y < getToSize(); y++)
-	  d_weights[x][y] = Rhs.d_weights[x][y];
-      }
-    }
-    if (Rhs.w_transpose != NULL) {
-      w_transpose = new double*[getToSize()];
-      for (x = 0; x < getToSize(); x++) {
-	w_transpose[x] = new double[getFromSize()];
-	for (y = 0; y < getFromSize(); y++)
-	  w_transpose[x][y] = Rhs.w_transpose[x][y];
-      }
-    }
-    if (Rhs.work_vec1 != NULL) {
-      work_vec1 = new double[getToSize()];
-      for (x = 0; x < getToSize(); x++)
-	work_vec1[x] = Rhs.work_vec1[x];
-    }
-    if (Rhs.work_vec2 != NULL) {
-      work_vec2 = new double[getToSize()];
-      for (x = 0; x < getToSize(); x++)
-	work_vec2[x] = Rhs.work_vec2[x];
-    }
-    if (Rhs.work_vec3 != NULL) {
-      work_vec3 = new double[getToLayer()->getNumberOfInputDimensions()];
-      for (x = 0; x < getToLayer()->getNumberOfInputDimensions(); x++)
-	work_vec3[x] = Rhs.work_vec3[x];
-    }
-    if (Rhs.work_vec4 != NULL) {
-      work_vec4 = new double[getToLayer()->getNumberOfInputDimensions()];
-      for (x = 0; x < getToLayer()->getNumberOfInputDimensions(); x++)
-	work_vec4[x] = Rhs.work_vec4[x];
-    }
-    if (Rhs.work_vec5 != NULL) {
-      work_vec5 = new double[getFromSize()];
-      for (x = 0; x < getFromSize(); x++)
-	work_vec5[x] = Rhs.work_vec5[x];
-    }
+    // Reuses the block when the shapes match.
+    storage = Rhs.storage;
+    if (Rhs.weights != NULL)
+      layoutStorage();
   }
   return *this;
 }
 
 FullForwardProjection::FullForwardProjection(Layer* from_layer, Layer* to_layer, int dimension) : Projection(from_layer, to_layer, dimension) {
 
-  if (from_layer == NULL || to_layer == NULL) {
-    init();
-    return;
-  }
+  init();
 
-  min_w = -1.0;
-  max_w = -1.0;
-  w_bound = false;
+  if (from_layer == NULL || to_layer == NULL)
+    return;
 
   int from_size = from_layer->Size();
   int to_size = to_layer->Size();
-  int x, y;
-
-  weights = new double*[from_size];
-  d_weights = new double*[from_size];
-  w_transpose = new double*[to_size];
-  work_vec1 = new double[to_size];
-  work_vec2 = new double[to_size];
-  work_vec3 = new double[to_layer->getNumberOfInputDimensions()];
-  work_vec4 = new double[to_layer->getNumberOfInputDimensions()];
-  work_vec5 = new double[from_size];
-
-  for (y = 0; y < to_size; y++)
-    w_transpose[y] = new double[from_size];
-
-  for (x = 0; x < from_size; x++) {
-    weights[x] = new double[to_size];
-    d_weights[x] = new double[to_size];
-    for (y = 0; y < to_size; y++) {
-      weights[x][y] = 0.0;
-      w_transpose[y][x] = 0.0;
-      d_weights[x][y] = 0.0;
-    }
-  }
 
+  // Allocated zeroed.
+  storage.allocate((3 * from_size * to_size) + (2 * to_size) +
+		   (2 * to_layer->getNumberOfInputDimensions()) + from_size);
+  layoutStorage();
 }
 
 bool FullForwardProjection::initializeWeights( RandomNumberGenerator* rand ) {
@@ -383,9 +285,13 @@ bool FullForwardProjection::computeNets() {
   if (weights == NULL || d_weights == NULL)
     return false;
 
-  getFromLayer()->getActs(work_vec5);
+  const double* acts = getFromLayer()->getBoundActs();
+  if (acts == NULL) {
+    getFromLayer()->getActs(work_vec5);
+    acts = work_vec5;
+  }
 
-  multiply(getFromLayer()->Size(), work_vec5, getToLayer()->Size(), weights, work_vec1);
+  multiply(getFromLayer()->Size(), acts, getToLayer()->Size(), weights, work_vec1);
 
   for (int y = 0; y < getToLayer()->Size(); y++) {
     getToLayer()->getUnit(y)->getNets(work_vec3);
@@ -402,9 +308,13 @@ bool FullForwardProjection::adjustNets() {
   if (weights == NULL || d_weights == NULL)
     return false;
 
-  getFromLayer()->getActs(work_vec5);
+  const double* acts = getFromLayer()->getBoundActs();
+  if (acts == NULL) {
+    getFromLayer()->getActs(work_vec5);
+    acts = work_vec5;
+  }
 
-  multiply(getFromLayer()->Size(), work_vec5, getToLayer()->Size(), weights, work_vec1);
+  multiply(getFromLayer()->Size(), acts, getToLayer()->Size(), weights, work_vec1);
 
   for (int y = 0; y < getToLayer()->Size(); y++) {
     getToLayer()->getUnit(y)->getNets(work_vec3);
@@ -429,6 +339,19 @@ double FullForwardProjection::getWeight(int from_layer_pos, int to_layer_pos) {
   return weights[from_layer_pos][to_layer_pos];
 }
 
+bool FullForwardProjection::copyWeights(FullForwardProjection* src) {
+  if (src == NULL || weights == NULL || src->weights == NULL)
+    return false;
+
+  if (src->getFromSize() != getFromSize() || src->getToSize() != getToSize() ||
+      src->storage.getLength() != storage.getLength())
+    return false;
+
+  storage = src->storage;
+
+  return true;
+}
+
 bool FullForwardProjection::setWeight(int from_layer_pos, int to_layer_pos, double val) {
   if (weights == NULL)
     return false;
@@ -453,8 +376,8 @@ double FullForwardProjection::bound(double val) {
     if (val > max_w)
       return max_w;
   }
-  else
-    return val;
+
+  return val;
 }
 
 void FullForwardProjection::useWeightBounding(bool val) {
@@ -35,6 +35,7 @@
 #define FULL_FORWARD_PROJECTION_H
 
 #include <projection.h>
+#include <numeric_arena.h>
 #include <fstream>
 
 class Layer;
@@ -45,12 +46,16 @@ using namespace std;
 class FullForwardProjection : public Projection {
 
  private:
-  double bound(double val);
-
+  // All of the numeric state below lives in this one block; the
+  // matrices are row pointers into it.
+  NumericArena storage;
   void init();
   void dispose();
+  bool layoutStorage();
 
  protected:
+  double bound(double val);
+
   double** weights;
   double** d_weights;
   double** w_transpose;
@@ -83,6 +88,10 @@ class FullForwardProjection : public Projection {
   bool setWeight(int from_layer_pos, int to_layer_pos, double val);
   double getWeight(int from_layer_pos, int to_layer_pos);
 
+  // Copies the weights (and the rest of the numeric state) of a
+  // projection of the same shape in one block copy.
+  bool copyWeights(FullForwardProjection* src);
+
   void useWeightBounding(bool val);
 
   double getWeightBoundMinimum();
@@ -67,6 +67,7 @@ Layer& Layer::operator=(const Layer& Rhs) {
     in_dims = Rhs.in_dims;
     num_units = Rhs.num_units;
     cross_entropy = Rhs.cross_entropy;
+    bound_acts = NULL;
     if (num_units > 0) {
       units = new NeuralUnit*[num_units];
       work_vec = new double[in_dims];
@@ -86,6 +87,7 @@ Layer::Layer(int number_of_units, ActivationFunction* af ) : NNetObject() {
   }
 
   cross_entropy = false;
+  bound_acts = NULL;
   num_units = number_of_units;
   in_dims = af->getNumberOfInputDimensions();
   act_func = af;
@@ -119,6 +121,7 @@ void Layer::dispose() {
 
 void Layer::init() {
   units = NULL;
+  bound_acts = NULL;
   act_func = NULL;
   in_dims = 0;
   num_units = 0;
@@ -347,6 +350,8 @@ bool Layer::setActs(double vals[]) {
   if (vals == NULL || units == NULL)
     return false;
 
+  bound_acts = NULL;
+
   for (int x = 0; x < num_units; x++)
     units[x]->setAct(vals[x]);
 
@@ -358,12 +363,32 @@ bool Layer::getActs(double vals[]) {
   if (vals == NULL || units == NULL)
     return false;
 
+  if (bound_acts != NULL) {
+    for (int x = 0; x < num_units; x++)
+      vals[x] = bound_acts[x];
+    return true;
+  }
+
   for (int x = 0; x < num_units; x++)
     vals[x] = units[x]->getAct();
 
   return true;
 }
 
+bool Layer::bindActs(const double* vals) {
+
+  if (units == NULL)
+    return false;
+
+  bound_acts = vals;
+
+  return true;
+}
+
+const double* Layer::getBoundActs() {
+  return bound_acts;
+}
+
 bool Layer::setNets(double* vals[]) {
 
   if (vals == NULL || units == NULL)
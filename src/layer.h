@@ -88,6 +88,14 @@ class Layer : public NNetObject {
   bool setActs(double vals[]);
   bool getActs(double vals[]);
 
+  // Borrowed-input mode: the layer's activations are read straight from
+  // the provided buffer (which the caller keeps alive) instead of from
+  // its units, so no copy is needed to present a vector to the layer.
+  // The units' own acts are not updated while bound. Binding NULL (or
+  // calling setActs) returns the layer to its units' acts.
+  bool bindActs(const double* vals);
+  const double* getBoundActs();
+
   bool setTargets(double vals[]);
   bool getTargets(double vals[]);
 
@@ -125,6 +133,7 @@ class Layer : public NNetObject {
 
  private:
   NeuralUnit** units;
+  const double* bound_acts;
   void dispose();
   void init();
 };
@@ -50,7 +50,7 @@ double multiply(int vector_size, double* vector) {
 	
 };
 
-void multiply(int vector_size, double* vector, int second_dimension, double** matrix, double* new_vector) {
+void multiply(int vector_size, const double* vector, int second_dimension, double** matrix, double* new_vector) {
 
   int x, y;
   for (x = 0; x < second_dimension; x++)
@@ -44,7 +44,7 @@ void increment(int dim1, int dim2, double** matrix1, double** matrix2);
 
 double multiply(int vector_size, double* vector);
 
-void multiply(int vector_size, double* vector, int second_dimension, double** matrix, double* new_vector);
+void multiply(int vector_size, const double* vector, int second_dimension, double** matrix, double* new_vector);
 
 void transpose(int dim1, int dim2, double** matrix, double** new_matrix);
 
@@ -0,0 +1,150 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+/******************************************************************************
+ * numeric_arena.cpp
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ *****************************************************************************/
+
+#include <numeric_arena.h>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#ifdef WMTK_HUGE_PAGES
+#include <sys/mman.h>
+#endif
+
+NumericArena::NumericArena() {
+  init();
+}
+
+NumericArena::NumericArena(const NumericArena& A) {
+  init();
+  copy(A);
+}
+
+NumericArena::~NumericArena() {
+  dispose();
+}
+
+NumericArena& NumericArena::operator=(const NumericArena& Rhs) {
+  if (this != &Rhs)
+    copy(Rhs);
+  return *this;
+}
+
+void NumericArena::swap(NumericArena& other) {
+  std::swap(block, other.block);
+  std::swap(length, other.length);
+  std::swap(huge_pages, other.huge_pages);
+}
+
+#if __cplusplus >= 201103L
+NumericArena::NumericArena(NumericArena&& L) noexcept {
+  init();
+  swap(L);
+}
+
+NumericArena& NumericArena::operator=(NumericArena&& Rhs) noexcept {
+  swap(Rhs);
+  return *this;
+}
+#endif
+
+void NumericArena::init() {
+  block = NULL;
+  length = 0;
+  huge_pages = false;
+}
+
+void NumericArena::dispose() {
+  if (block != NULL)
+    free(block);
+  init();
+}
+
+void NumericArena::copy(const NumericArena& src) {
+  // An arena of the same length is reused, so cloning into an existing
+  // network costs a single memcpy and no allocation.
+  if (length != src.length && !allocate(src.length))
+    return;
+
+  if (length > 0)
+    memcpy(block, src.block, length * sizeof(double));
+}
+
+bool NumericArena::allocate(size_t number_of_doubles) {
+  dispose();
+
+  if (number_of_doubles == 0)
+    return true;
+
+  size_t bytes = number_of_doubles * sizeof(double);
+  size_t alignment = WMTK_ARENA_ALIGNMENT;
+  void* memory = NULL;
+
+#ifdef WMTK_HUGE_PAGES
+  if (bytes >= WMTK_HUGE_PAGE_SIZE) {
+    alignment = WMTK_HUGE_PAGE_SIZE;
+    bytes = ((bytes + WMTK_HUGE_PAGE_SIZE - 1) / WMTK_HUGE_PAGE_SIZE) *
+      WMTK_HUGE_PAGE_SIZE;
+    huge_pages = true;
+  }
+#endif
+
+  if (posix_memalign(&memory, alignment, bytes) != 0) {
+    huge_pages = false;
+    return false;
+  }
+
+#if defined(WMTK_HUGE_PAGES) && defined(MADV_HUGEPAGE)
+  if (huge_pages)
+    madvise(memory, bytes, MADV_HUGEPAGE);
+#endif
+
+  block = (double*)memory;
+  length = number_of_doubles;
+  memset(block, 0, bytes);
+
+  return true;
+}
+
+void NumericArena::release() {
+  dispose();
+}
+
+double* NumericArena::at(size_t offset) const {
+  if (block == NULL)
+    return NULL;
+  return block + offset;
+}
+
+size_t NumericArena::getLength() const {
+  return length;
+}
+
+bool NumericArena::isHugePageBacked() const {
+  return huge_pages;
+}
@@ -0,0 +1,90 @@
+// Working Memory Toolkit (WMtk)
+// Adaptive Working Memory Library for Robot Control Systems
+// Copyright (C) 2005, Joshua L. Phillips & David C. Noelle
+// Department of Electrical Engineering and Computer Science
+// Vanderbilt University; Nashville, Tennessee, USA.
+// Email:  WMtk-Devel@ccnl.vuse.vanderbilt.edu
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+/******************************************************************************
+ * numeric_arena.h
+ *
+ * This software is part of the NSF ITR Robot-PFC Working Memory Toolkit.
+ *
+ * The NumericArena class owns one contiguous, aligned block of doubles.
+ * Network objects lay all of their numeric state (weights, traces and
+ * scratch vectors) out in a single arena and refer to the pieces by
+ * offset, so that copying a network copies one block with memcpy
+ * instead of allocating and filling every array separately.
+ *
+ * When compiled with WMTK_HUGE_PAGES defined, arenas of at least
+ * WMTK_HUGE_PAGE_SIZE bytes are aligned to (and padded out to) the
+ * huge page size and advised to the kernel as huge page candidates,
+ * which cuts TLB misses when streaming over wide weight vectors.
+ *
+ *****************************************************************************/
+
+#ifndef NUMERIC_ARENA_H
+#define NUMERIC_ARENA_H
+
+#include <cstddef>
+
+#define WMTK_ARENA_ALIGNMENT 64
+#define WMTK_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+class NumericArena {
+
+ public:
+  NumericArena();
+  NumericArena(const NumericArena&);
+  ~NumericArena();
+  NumericArena& operator=(const NumericArena&);
+
+  // Exchanges the blocks of two arenas.
+  void swap(NumericArena&);
+
+#if __cplusplus >= 201103L
+  NumericArena(NumericArena&&) noexcept;
+  NumericArena& operator=(NumericArena&&) noexcept;
+#endif
+
+  // Allocates a zeroed arena of the given number of doubles, releasing
+  // any previous block. Returns false if the allocation failed.
+  bool allocate(size_t number_of_doubles);
+
+  // Frees the block.
+  void release();
+
+  // Returns the address of the double at the given offset (NULL if the
+  // arena is empty).
+  double* at(size_t offset) const;
+
+  size_t getLength() const;
+
+  // True if the block was allocated on huge page boundaries.
+  bool isHugePageBacked() const;
+
+ private:
+  double* block;
+  size_t length;
+  bool huge_pages;
+
+  void init();
+  void dispose();
+  void copy(const NumericArena&);
+};
+
+#endif
@@ -49,57 +49,63 @@ TDFullForwardProjection::~TDFullForwardProjection() {
 
 void TDFullForwardProjection::init() {
   e_traces = NULL;
+  staged_acts = NULL;
   lambda = 0.0;
   critic_layer = NULL;
 }
 
 void TDFullForwardProjection::dispose() {
   if (e_traces != NULL) {
-    for (int x = 0; x < getFromSize(); x++) {
-      for (int y = 0; y < getToSize(); y++)
-	delete [] e_traces[x][y];
-      delete [] e_traces[x];
-    }
+    delete [] e_traces[0];
     delete [] e_traces;
   }
+  trace_storage.release();
+  e_traces = NULL;
+}
+
+// Builds the [from][to] index of trace vectors over the trace arena.
+bool TDFullForwardProjection::layoutTraces() {
+  int from_size = getFromSize();
+  int to_size = getToSize();
+  int critic_size = critic_layer->Size();
+  int x, y;
+
+  if (from_size < 1 || to_size < 1 ||
+      trace_storage.getLength() != (size_t) (from_size * to_size * critic_size))
+    return false;
+
+  double** rows = new double*[from_size * to_size];
+  e_traces = new double**[from_size];
+  for (x = 0; x < from_size; x++) {
+    e_traces[x] = rows + (x * to_size);
+    for (y = 0; y < to_size; y++)
+      e_traces[x][y] = trace_storage.at(((x * to_size) + y) * critic_size);
+  }
+
+  return true;
 }
 
-TDFullForwardProjection::TDFullForwardProjection(const TDFullForwardProjection& L) : BpFullForwardProjection(L) {
-  int x,y,z;
+TDFullForwardProjection::TDFullForwardProjection(const TDFullForwardProjection& L) : BpFullForwardProjection(L), trace_storage(L.trace_storage) {
   init();
   lambda = L.lambda;
   critic_layer = L.critic_layer;
-  if (L.e_traces != NULL) {
-    e_traces = new double**[getFromSize()];
-    for (x = 0; x < getFromSize(); x++) {
-      e_traces[x] = new double*[getToSize()];
-      for (y = 0; y < getToSize(); y++) {
-	e_traces[x][y] = new double[critic_layer->Size()];
-	for (z = 0; z < critic_layer->Size(); z++)
-	  e_traces[x][y][z] = L.e_traces[x][y][z];
-      }
-    }
-  }
+  if (L.e_traces != NULL)
+    layoutTraces();
 }
 
 TDFullForwardProjection& TDFullForwardProjection::operator=(const TDFullForwardProjection& Rhs) {
-  int x,y,z;
   if (this != &Rhs) {
     BpFullForwardProjection::operator=(Rhs);
-    dispose();
+    if (e_traces != NULL) {
+      delete [] e_traces[0];
+      delete [] e_traces;
+    }
+    init();
     lambda = Rhs.lambda;
     critic_layer = Rhs.critic_layer;
-    if (Rhs.e_traces != NULL) {
-      e_traces = new double**[getFromSize()];
-      for (x = 0; x < getFromSize(); x++) {
-	e_traces[x] = new double*[getToSize()];
-	for (y = 0; y < getToSize(); y++) {
-	  e_traces[x][y] = new double[critic_layer->Size()];
-	  for (z = 0; z < critic_layer->Size(); z++)
-	    e_traces[x][y][z] = Rhs.e_traces[x][y][z];
-	}
-      }
-    }
+    trace_storage = Rhs.trace_storage;
+    if (Rhs.e_traces != NULL)
+      layoutTraces();
   }
   return *this;
 }
@@ -107,12 +113,10 @@ TDFullForwardProjection& TDFullForwardProjection::operator=(const TDFullForwardP
 TDFullForwardProjection::TDFullForwardProjection(Layer* from_layer, Layer*
 						 to_layer, int dimension, double lambda_value, TDLayer* critic_output_layer) : BpFullForwardProjection(from_layer, to_layer, dimension) {
 
-  int x,y,z;
+  init();
 
-  if (from_layer == NULL || to_layer == NULL || critic_output_layer == NULL) {
-    init();
+  if (from_layer == NULL || to_layer == NULL || critic_output_layer == NULL)
     return;
-  }
 
   critic_layer = critic_output_layer;
   lambda = lambda_value;
@@ -120,16 +124,10 @@ TDFullForwardProjection::TDFullForwardProjection(Layer* from_layer, Layer*
   if (lambda_value < 0.0 || lambda_value > 1.0)
     lambda = 0.0;
 
-  e_traces = new double**[from_layer->Size()];
-  for (x = 0; x < from_layer->Size(); x++) {
-    e_traces[x] = new double*[to_layer->Size()];
-    for (y = 0; y < to_layer->Size(); y++) {
-      e_traces[x][y] = new double[critic_layer->Size()];
-      for (z = 0; z < critic_layer->Size(); z++)
-	e_traces[x][y][z] = 0.0;
-    }
-  }
-
+  // Allocated zeroed.
+  trace_storage.allocate(from_layer->Size() * to_layer->Size() *
+			 critic_layer->Size());
+  layoutTraces();
 }
 
 bool TDFullForwardProjection::updateEligibilityTraces(int critic_unit) {
@@ -198,6 +196,75 @@ bool TDFullForwardProjection::computeWeightChanges(int critic_unit) {
 
 }
 
+bool TDFullForwardProjection::stageEligibilityGradient(int critic_unit) {
+  return stageEligibilityGradient(critic_unit, NULL);
+}
+
+bool TDFullForwardProjection::stageEligibilityGradient(int critic_unit, const double* from_acts) {
+  if (weights == NULL || e_traces == NULL)
+    return false;
+
+  if (critic_unit < 0 || critic_unit >= critic_layer->Size())
+    return false;
+
+  if (from_acts == NULL)
+    from_acts = getFromLayer()->getBoundActs();
+
+  if (from_acts != NULL)
+    staged_acts = from_acts;
+  else {
+    getFromLayer()->getActs(from_work_vec1);
+    staged_acts = from_work_vec1;
+  }
+
+  for (int y = 0; y < getToLayer()->Size(); y++) {
+    getToLayer()->getUnit(y)->getDeltas(work_vec3);
+    to_work_vec1[y] = work_vec3[getDimension()];
+  }
+
+  return true;
+}
+
+bool TDFullForwardProjection::updateTracesAndWeights(int critic_unit) {
+  return updateTracesAndWeights(critic_unit, NULL, NULL);
+}
+
+bool TDFullForwardProjection::updateTracesAndWeights(int critic_unit, const double* next_acts, double* net_changes) {
+  if (weights == NULL || e_traces == NULL || staged_acts == NULL)
+    return false;
+
+  if (critic_unit < 0 || critic_unit >= critic_layer->Size())
+    return false;
+
+  int x, y;
+  int from_size = getFromLayer()->Size();
+  int to_size = getToLayer()->Size();
+  double decay = critic_layer->getDiscountRate() * lambda;
+  double step = getLearningRate() * critic_layer->getTDError(critic_unit);
+  double trace;
+  double old_weight;
+
+  if (net_changes == NULL)
+    next_acts = NULL;
+
+  // Single streaming pass: trace decay, gradient, weight change, bound
+  for (x = 0; x < from_size; x++)
+    for (y = 0; y < to_size; y++) {
+      trace = (decay * e_traces[x][y][critic_unit]) +
+	(to_work_vec1[y] * staged_acts[x]);
+      e_traces[x][y][critic_unit] = trace;
+      old_weight = weights[x][y];
+      weights[x][y] = bound(old_weight + (step * trace));
+      w_transpose[y][x] = weights[x][y];
+      if (next_acts != NULL)
+	net_changes[y] += (weights[x][y] - old_weight) * next_acts[x];
+    }
+
+  staged_acts = NULL;
+
+  return true;
+}
+
 bool TDFullForwardProjection::clearEligibilityTraces() {
   if (e_traces == NULL)
     return false;
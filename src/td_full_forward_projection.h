@@ -61,17 +61,39 @@ public:
   bool computeWeightChanges();
   bool computeWeightChanges(int critic_unit);
 
+  // Fused TD(lambda) step. The gradient for the time step being left
+  // (from-layer acts and to-layer deltas) is staged first; then one
+  // pass over the weights decays the traces, adds the staged gradient,
+  // and applies learning_rate * td_error * trace straight to the
+  // (bounded) weights without going through d_weights.
+  //
+  // The from-layer acts may be supplied by the caller instead of being
+  // read from the layer; that buffer must stay valid until the update.
+  // If next_acts is given, the change in each to-unit's net input
+  // caused by the update is added to net_changes (so the new nets for
+  // next_acts do not need another forward pass).
+  bool stageEligibilityGradient(int critic_unit);
+  bool stageEligibilityGradient(int critic_unit, const double* from_acts);
+  bool updateTracesAndWeights(int critic_unit);
+  bool updateTracesAndWeights(int critic_unit, const double* next_acts,
+			      double* net_changes);
+
   bool clearEligibilityTraces();
 
   void printEligibilityTraces();
 
 private:
+  // Traces live in one arena, indexed [from][to][critic unit] through
+  // e_traces.
+  NumericArena trace_storage;
   double*** e_traces;
+  const double* staged_acts;
   double lambda;
   TDLayer* critic_layer;
 
   void init();
   void dispose();
+  bool layoutTraces();
 
 };
 